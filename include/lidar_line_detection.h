@@ -4,9 +4,14 @@
 #include <opencv2/opencv.hpp>
 #include <string>
 #include <vector>
+#include <memory>
+#include <cstdint>
+#include <functional>
 
-// 版本信息
-#define LIDAR_LINE_DETECTION_VERSION_MAJOR 1
+namespace spdlog { class logger; }
+
+// 版本信息（C接口结构体的大小或布局变化时升主版本号）
+#define LIDAR_LINE_DETECTION_VERSION_MAJOR 2
 #define LIDAR_LINE_DETECTION_VERSION_MINOR 0
 #define LIDAR_LINE_DETECTION_VERSION_PATCH 0
 
@@ -18,7 +23,8 @@ enum class DetectionResultCode {
     IMAGE_LOAD_FAILED = 3,  // 图像加载失败
     CONFIG_LOAD_FAILED = 4, // 配置加载失败
     ROI_INVALID = 5,        // ROI无效
-    IMAGE_SAVE_FAILED = 6,  // 图像保存失败
+    IMAGE_SAVE_FAILED = 6,  // 图像保存失败：仅同步写盘时由 detect 返回（线已检出，结果图写盘失败）；
+                            // 异步写盘的失败在后台发生，只计入 getOutputStats().failed
     CAMERA_SELF_CHECK_FAILED = 7, // 相机自检失败
     UNKNOWN_ERROR = 100      // 兜底
 };
@@ -28,6 +34,10 @@ struct LidarDetectionResult {
     DetectionResultCode status;   // 检测状态/错误码
     float line_angle;             // 检测到的线的角度（仅SUCCESS时有效）
     std::string image_path;       // 结果图像路径（可选）
+    int inlier_count;             // 参与最终拟合的内点数
+    int fit_iterations;           // 拟合迭代次数（最小二乘为1）
+    int threshold;                // 本帧实际使用的强度阈值（自适应模式下为自动选取值）
+    bool image_save_failed;       // 同步写盘时结果图保存失败（异步写盘时恒为false）
 };
 
 // 版本信息结构 - 移至错误码定义之后，确保所有依赖都已定义
@@ -59,6 +69,9 @@ struct TLidarLineResult_C {
     float line_angle; // 直线角度（弧度）
     char image_path[256];
     int error_code; // 修正为int类型
+    int inlier_count;   // 参与最终拟合的内点数
+    int fit_iterations; // 拟合迭代次数
+    int threshold;      // 本帧实际使用的强度阈值
 };
 
 struct TTargetConfig_C {
@@ -67,6 +80,27 @@ struct TTargetConfig_C {
     float tolerance; // 允许的像素偏差
 };
 
+// 异步输出队列计数（每个检测实例一个队列）
+struct TArtifactQueueStats_C {
+    unsigned long long submitted; // 已入队
+    unsigned long long written;   // 已写盘
+    unsigned long long dropped;   // 队列满被丢弃
+    unsigned long long failed;    // 编码/写盘失败
+    int pending;                  // 当前排队及正在写盘的数量
+    int peak_pending;             // 历史最大排队数
+};
+
+// 输出目录保留策略统计（同一目录的保留策略在进程内共享，统计为共用该目录的全部实例之和）
+struct TRetentionStats_C {
+    unsigned long long tracked_bytes;     // 当前统计在内的占用
+    unsigned long long tracked_files;
+    unsigned long long reclaimed_bytes;   // 累计回收
+    unsigned long long reclaimed_files;
+    unsigned long long expired_files;     // 因超龄删除
+    unsigned long long quota_evictions;   // 因超出配额删除
+    unsigned long long delete_failures;   // 删除失败（如文件仍被占用）
+};
+
 struct TargetMovementResult_C {
     int is_stable;
     float dx;
@@ -77,6 +111,9 @@ struct TargetMovementResult_C {
 };
 #pragma pack(pop)
 
+// 按值返回给调用方的结果结构体布局固定：2.0.0 起在 1.x 的末尾追加了内点数、迭代次数与阈值
+static_assert(sizeof(TLidarLineResult_C) == 277, "TLidarLineResult_C layout (ABI 2.x)");
+
 // C接口结构体
 #pragma pack(push, 1)
 struct TLidarDetectionResult_C {
@@ -108,6 +145,9 @@ struct LidarLineResult {
     float line_angle;
     std::string image_path;
     DetectionResultCode error_code;
+    int inlier_count;
+    int fit_iterations;
+    int threshold;
 };
 
 struct TargetConfig {
@@ -115,18 +155,556 @@ struct TargetConfig {
     float tolerance;
 };
 
+// 标靶方块查找引擎
+enum class TargetFinder {
+    CONTOURS = 0,   // 二值化 + 开闭运算 + 轮廓、四边形近似与矩
+    COMPONENTS = 1  // 二值化与开闭运算合并为一个滑窗内核，连通域标记一次得到面积、外接矩形、质心与填充率
+};
+
+// 相机自检的标靶搜索参数
+struct TargetSearchOptions {
+    bool windowed = false;     // 只在预期方块位置附近的四个窗口内搜索，任一窗口未命中再回退整图搜索
+    int windowMargin = 48;     // 窗口在方块边长两侧各外扩的像素数，应大于需要检出的最大偏移
+    bool renderDisplay = true; // 是否生成显示图像（检测结束后单独绘制；不需要时整图颜色转换与绘制都不执行）
+    bool cropDisplay = false;  // 显示图像只覆盖标靶（方块、中心、预期位置与容差圆）外扩 displayMargin 的区域，左上角见 TargetSearchState::displayOrigin
+    int displayMargin = 32;
+    TargetFinder finder = TargetFinder::CONTOURS;
+    float minFillRatio = 0.8f; // 连通域引擎：面积/外接矩形面积下限（排除圆形等非方块；方块旋转约7°时降到0.8）
+    bool phaseShift = false;   // 有参考频谱时先用相位相关估计整体平移，偏差接近容差或相关峰过弱才做方块检测
+    float escalateRatio = 0.5f; // 估计偏差达到 tolerance 的该比例时升级为方块检测
+    float minResponse = 0.1f;   // 相关峰值下限（0~1），低于此值认为估计不可靠
+    bool tracking = false;      // 检测成功后逐帧跟踪四个方块中心（金字塔LK，只处理四个小块），丢失或到期再检测
+    int redetectEvery = 100;    // 连续跟踪该帧数后强制重新检测
+    int trackMargin = 24;       // 跟踪块在方块边长两侧各外扩的像素数，即可跟踪的最大位移
+    float maxTrackError = 30.0f; // LK匹配误差（窗口内平均灰度差）上限
+};
+
+// 相位相关参考：调试时由参考帧（降采样灰度、去均值、Hanning窗、补零到最优DFT尺寸）计算的复数频谱，
+// 与参考帧上检测到的标靶中心一起缓存到标靶配置文件旁，之后每帧只需对当前帧做一次正变换
+struct PhaseReference {
+    bool valid = false;
+    int downsample = 4;     // 降采样倍率
+    cv::Size imageSize;     // 参考帧原图尺寸，当前帧尺寸不同时不使用
+    cv::Size sampleSize;    // 降采样后（补零前）的尺寸
+    cv::Mat spectrum;       // CV_32FC2
+    cv::Mat window;         // sampleSize 的 Hanning 窗（加载时重新生成，不写入文件）
+    cv::Point2f center;     // 参考帧上的标靶中心
+};
+
+// 标靶方块候选：中心与外接矩形均为整图坐标
+struct TargetSquare {
+    cv::Point2f center;
+    cv::Rect rect;
+};
+
+// 相机自检的工作缓冲：随 TargetSearchState 逐帧复用，图像尺寸与搜索方式不变时不再重新申请。
+// OpenCV 函数内部的临时缓冲（轮廓提取、连通域标记、DFT、LK金字塔）不在此列
+struct TargetSearchScratch {
+    cv::Mat gray;                        // 整图、窗口或跟踪块的灰度
+    cv::Mat binary, morph, kernel;       // 二值化与开闭运算（轮廓引擎的结构元只生成一次）
+    cv::Mat labels, stats, centroids;    // 连通域标记
+    std::vector<int> counts;             // 列方向滑窗计数
+    std::vector<std::vector<cv::Point>> contours;
+    std::vector<cv::Point> approx;
+    std::vector<TargetSquare> squares;   // 本帧找到的方块
+    std::vector<TargetSquare> found;     // 单个窗口内的候选
+    cv::Mat sample, sampleF, padded, spectrum, cross, correlation; // 相位相关
+    std::vector<cv::Point2f> prevPts, nextPts;
+    std::vector<uchar> status;
+    std::vector<float> errors;
+};
+
+// 标靶搜索状态（由调用方持有，如 CLidarLineDetector 实例）：整图搜索成功时学习四个方块（左上、右上、左下、右下）
+// 相对标靶中心的偏移与平均边长，窗口搜索据此在 expected_center 周围布置窗口
+struct TargetSearchState {
+    bool geometryValid = false;
+    cv::Point2f cornerOffsets[4];
+    float squareSize = 0;
+    uint64_t windowHits = 0; // 窗口搜索命中/回退整图次数
+    uint64_t fallbacks = 0;
+    PhaseReference reference;
+    uint64_t phaseHits = 0;    // 相位相关直接给出结果/升级为方块检测的次数
+    uint64_t escalations = 0;
+    // 跟踪：检测成功那一帧四个方块周围的灰度块作为模板，之后每帧在同一位置取当前帧灰度块求位移（模板不随帧更新，不累积漂移）
+    bool trackValid = false;
+    cv::Mat trackPatches[4];
+    cv::Rect trackRects[4];
+    cv::Point2f trackOrigins[4]; // 模板帧上的方块中心
+    int framesSinceDetect = 0;
+    uint64_t trackHits = 0;      // 跟踪给出结果/跟踪丢失的次数
+    uint64_t trackLosses = 0;
+    cv::Point displayOrigin;     // 最近一次显示图像左上角的原图坐标（cropDisplay 时非零）
+    TargetSearchScratch scratch;
+};
+
+// 激光强度来源：彩色图像取亮度或单一通道（单通道图像忽略此项）
+enum class IntensityChannel {
+    LUMINANCE = 0, // 亮度，与 cvtColor(COLOR_BGR2GRAY) 一致
+    BLUE = 1,
+    GREEN = 2,
+    RED = 3        // 红色激光推荐
+};
+
+// 原始Bayer图像（CV_8UC1）的排列，按图像左上角2x2像素命名；NONE 表示普通单通道图像
+enum class LaserBayerPattern {
+    NONE = 0,
+    RGGB = 1,
+    BGGR = 2,
+    GRBG = 3,
+    GBRG = 4
+};
+
+// 检测内核支持的像素格式，由 Mat::type() 与 bayerPattern 决定
+enum class LaserPixelFormat {
+    UNSUPPORTED = 0,
+    MONO8 = 1,   // CV_8UC1
+    BGR8 = 2,    // CV_8UC3
+    BGRA8 = 3,   // CV_8UC4
+    MONO16 = 4,  // CV_16UC1，强度取 v >> mono16Shift
+    BAYER8 = 5   // CV_8UC1 + bayerPattern，按所在2x2单元换算，不做去马赛克
+};
+
+// 激光点提取方式
+enum class LaserExtractionMode {
+    THRESHOLD = 0,       // 所有强度 > 阈值的像素都参与拟合
+    COLUMN_CENTROID = 1, // 每列一个亚像素中心：高于阈值部分的灰度重心
+    COLUMN_PEAK = 2      // 每列一个亚像素中心：峰值处抛物线插值（饱和平顶时退化为重心）
+};
+
+// 阈值选取方式
+enum class LaserThresholdMode {
+    FIXED = 0,      // 固定阈值 threshold
+    PERCENTILE = 1, // 取ROI强度直方图的百分位（只扫描行带时未扫描的行按背景计，行带含全部激光时与扫描整个ROI相同）
+    OTSU = 2        // ROI强度直方图上的Otsu阈值（依赖全部背景像素，此模式下跟踪与粗到细不收窄扫描行范围）
+};
+
+// 直线拟合方式
+enum class LaserFitMode {
+    LEAST_SQUARES = 0, // 全部点最小二乘（等价于 fitLine DIST_L2）
+    RANSAC = 1         // 有界抽样点集上的RANSAC，再对内点做最小二乘，抗反光干扰
+};
+
+// 结果图保存时机
+enum class LaserArtifactTrigger {
+    ALWAYS = 0,        // 每帧保存
+    FAILURES_ONLY = 1, // 仅保存检测失败的帧
+    NEVER = 2          // 不保存
+};
+
+// 结果图编码格式
+enum class LaserArtifactFormat {
+    JPEG = 0,
+    PNG = 1
+};
+
+// 结果图保存策略：每帧至多编码一张图，ROI框、激光点、拟合直线与失败原因都绘制在这一张图上
+struct LaserArtifactPolicy {
+    LaserArtifactTrigger trigger = LaserArtifactTrigger::ALWAYS;
+    int sampleEvery = 1;    // 满足保存时机的帧中每 N 帧保存一帧
+    int maxPerMinute = 0;   // 每分钟保存上限（令牌桶，允许一分钟额度内的突发），0 不限
+    bool cropToROI = false; // 只保存ROI（多ROI时为并集）外扩 cropMargin 像素的区域
+    int cropMargin = 16;
+    float scale = 1.0f;     // 缩略图比例 (0,1]，标注绘制完成后按面积插值缩小
+    LaserArtifactFormat format = LaserArtifactFormat::JPEG;
+    int jpegQuality = 95;   // 0-100
+    int pngCompression = 3; // 0-9
+    bool drawPoints = true; // 在结果图上标出提取的激光点
+};
+
+// 行带并行线程池：run 把 taskCount 个任务分给工作线程与调用线程，全部完成后返回
+// 同一时刻只服务一个 run，其余并发调用（如多ROI并行）直接在调用线程内顺序执行
+class LaserWorkerPool {
+public:
+    explicit LaserWorkerPool(int threads); // threads 含调用线程，<=1 时不创建工作线程
+    ~LaserWorkerPool();
+    LaserWorkerPool(const LaserWorkerPool&) = delete;
+    LaserWorkerPool& operator=(const LaserWorkerPool&) = delete;
+
+    int threadCount() const;
+    void run(int taskCount, const std::function<void(int)>& task);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+class SessionVideoSink;
+class RetentionManager;
+
+// 结果/调试图异步写盘器：容量固定的缓冲池兼作有界队列，调用方把图像直接绘制在池化缓冲中后提交，
+// 后台线程负责编码写盘；缓冲用尽时按策略丢弃或阻塞等待
+class ArtifactWriter {
+public:
+    enum class OverflowPolicy {
+        DROP = 0,  // 丢弃本次输出，检测不受磁盘影响
+        BLOCK = 1  // 阻塞等待空闲缓冲
+    };
+    struct Stats {
+        uint64_t submitted = 0;
+        uint64_t written = 0;
+        uint64_t dropped = 0;
+        uint64_t failed = 0;
+        int pending = 0;
+        int peakPending = 0;
+    };
+
+    ArtifactWriter(int capacity, OverflowPolicy policy);
+    ~ArtifactWriter(); // 写完队列中剩余的图像后退出
+    ArtifactWriter(const ArtifactWriter&) = delete;
+    ArtifactWriter& operator=(const ArtifactWriter&) = delete;
+
+    cv::Mat* acquire(); // 取得空闲缓冲；DROP 策略下无空闲缓冲时返回nullptr
+    // retention 非空时在写盘成功后把文件登记到保留策略台账（failure 为失败图像）
+    void submit(cv::Mat* buffer, const std::string& path, const std::vector<int>& params = std::vector<int>(),
+                RetentionManager* retention = nullptr, bool failure = false);
+    void submit(cv::Mat* buffer, SessionVideoSink* sink, const std::string& sn); // 追加到会话视频而不是单独编码成文件
+    void release(cv::Mat* buffer); // 放弃已取得但不再提交的缓冲
+    bool flush(int timeoutMs); // 等待队列写空，timeoutMs < 0 时一直等待；超时返回false
+    Stats stats() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+// 结果图抽样与限速状态（每个检测实例一个），可被多个检测线程同时调用
+class ArtifactBudget {
+public:
+    ArtifactBudget();
+    ~ArtifactBudget();
+    ArtifactBudget(const ArtifactBudget&) = delete;
+    ArtifactBudget& operator=(const ArtifactBudget&) = delete;
+
+    // 帧已满足保存时机后调用：按 1/N 抽样与每分钟上限判定本帧是否保存
+    bool admit(const LaserArtifactPolicy& policy);
+    void reset(); // 策略变更时清零计数并补满令牌
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+// 输出目录保留策略：后台线程按字节配额与最长保留时间删除旧文件，失败图像优先保留。
+// 每个根目录在进程内只有一个实例（forRoot 取得，多个检测实例共享同一台账与配额），
+// 启动时扫描一次根目录建立台账，之后只统计 track 登记的新文件，不再重复遍历目录。
+// 失败图像按文件名识别（.llfr 飞行记录转存、result_fail_ 前缀的结果图），重启后仍优先保留；
+// 日志（log 根目录与 .log 文件）只按保留时间删除，不计入配额；本进程日志仍打开着的文件不删除
+class RetentionManager {
+public:
+    struct Policy {
+        uint64_t quotaBytes = 0;        // 0 不限
+        int maxAgeSeconds = 0;          // 普通文件最长保留时间，0 不限
+        int failureMaxAgeSeconds = 0;   // 失败图像/飞行记录最长保留时间，0 不限
+        int intervalMs = 5000;          // 后台检查间隔
+    };
+    struct Stats {
+        uint64_t trackedBytes = 0;
+        uint64_t trackedFiles = 0;
+        uint64_t reclaimedBytes = 0;
+        uint64_t reclaimedFiles = 0;
+        uint64_t expiredFiles = 0;
+        uint64_t quotaEvictions = 0;
+        uint64_t deleteFailures = 0;
+    };
+
+    // 取得 root 的进程级实例（不存在时创建并启动后台线程），已存在时以 policy 替换其策略
+    static std::shared_ptr<RetentionManager> forRoot(const std::string& root, const Policy& policy);
+    ~RetentionManager();
+    RetentionManager(const RetentionManager&) = delete;
+    RetentionManager& operator=(const RetentionManager&) = delete;
+
+    // 登记已写完的文件，只入队不访问文件系统；超出配额时先删除非失败文件
+    void track(const std::string& path, bool failure);
+    // 正在写入的文件（飞行记录环形文件、会话视频索引与当前分段）：扫描与登记时跳过，已在台账中的不删除
+    void protect(const std::string& path);
+    void release(const std::string& path);
+    void setPolicy(const Policy& policy); // 下一个检查周期生效
+    Stats stats() const;
+
+private:
+    RetentionManager(const std::string& root, const Policy& policy);
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+// 会话视频输出：结果图按帧追加到分段的 MJPEG/AVI 文件（<base>_0001.avi ...），文件数量恒定、顺序写盘。
+// 旁路索引 <base>.idx 每帧一行：分段文件名,帧序号,时间戳(微秒),宽,高,SN，可按SN取回单帧
+class SessionVideoSink {
+public:
+    // basePath 为不含扩展名的会话路径；framesPerSegment 帧后换新分段，帧尺寸变化时也换新分段
+    SessionVideoSink(const std::string& basePath, int framesPerSegment, double fps, int quality, RetentionManager* retention = nullptr);
+    ~SessionVideoSink();
+    SessionVideoSink(const SessionVideoSink&) = delete;
+    SessionVideoSink& operator=(const SessionVideoSink&) = delete;
+
+    // 追加一帧8位BGR图像，成功时 location 为 "<分段文件>#<帧序号>"；可被多个线程同时调用
+    bool append(const cv::Mat& bgr, const std::string& sn, std::string& location);
+    std::string indexPath() const;
+    void setRetention(RetentionManager* retention); // 分段定稿后登记到的保留策略台账，可为空
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+// 按SN从会话索引中取回一帧；同一SN有多帧时 occurrence 为序号（从0开始），-1 取最后一帧
+bool readSessionFrame(const std::string& indexPath, const std::string& sn, cv::Mat& frame, int occurrence = -1);
+
+// 飞行记录中的一条：某个ROI一帧的原始像素与检测结果
+struct FlightRecord {
+    uint64_t sequence = 0;    // 记录序号（从1开始递增）
+    int64_t timestampUs = 0;  // 记录时刻（系统时钟，自1970年起的微秒数）
+    int roiIndex = 0;         // 多ROI检测中的序号
+    int roiX = 0, roiY = 0, roiWidth = 0, roiHeight = 0;
+    LaserBayerPattern bayerPattern = LaserBayerPattern::NONE; // 已按ROI起点奇偶换算为ROI自身的排列
+    int status = 0;           // DetectionResultCode
+    float lineAngle = 0.0f;   // 弧度
+    int threshold = 0;
+    int pointCount = 0;
+    int inliers = 0;
+    int scanUs = 0;           // 检测耗时（微秒）
+    cv::Mat image;            // 原始ROI像素；超出槽容量时只保存前若干行
+};
+
+// 飞行记录仪：最近 slotCount 条记录写入预分配的内存映射环形文件，记录时只复制原始像素、不做编码。
+// 失败或显式触发时把最近的窗口转存为独立文件，转存文件与环形文件格式相同，可由 readFlightRecords 读回
+class FlightRecorder {
+public:
+    FlightRecorder();
+    ~FlightRecorder();
+    FlightRecorder(const FlightRecorder&) = delete;
+    FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+    // 创建（覆盖）环形文件并映射到内存，slotBytes 为单条记录的像素容量
+    bool open(const std::string& path, int slotCount, int slotBytes);
+    void close();
+    bool isOpen() const;
+    // 写入一条记录，meta.sequence/timestampUs/image 由记录仪填写；可被多个检测线程同时调用，
+    // 落在同一槽的写端按槽串行（并发写端数超过 slotCount 时较旧的记录可能被丢弃）
+    void record(const cv::Mat& roiView, const FlightRecord& meta);
+    // 把最近 window 条记录按序号写入 dumpPath，返回写入条数；自上次转存以来的新记录少于 minNewRecords 时跳过并返回0
+    int dump(const std::string& dumpPath, int window, int minNewRecords = 0);
+    uint64_t recorded() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+// 读取环形文件或转存文件中的全部有效记录，按序号升序排列
+bool readFlightRecords(const std::string& path, std::vector<FlightRecord>& records);
+
+struct LaserScratchArena;
+
+// 激光线检测参数
+struct LaserDetectionOptions {
+    IntensityChannel channel = IntensityChannel::LUMINANCE;
+    uchar threshold = 220; // 强度 > threshold 视为激光点（16位图像同样按右移后的8位强度比较）
+    LaserBayerPattern bayerPattern = LaserBayerPattern::NONE; // 单通道输入为原始Bayer数据时设置
+    int mono16Shift = 8;   // 16位单通道换算为8位强度的右移位数（12位相机取4）
+    LaserExtractionMode extractionMode = LaserExtractionMode::THRESHOLD;
+
+    // 自适应阈值：直方图与候选点提取在同一次扫描中完成，不额外遍历图像
+    LaserThresholdMode thresholdMode = LaserThresholdMode::FIXED;
+    float adaptivePercentile = 99.0f;   // 百分位模式：强度高于阈值的像素约占 (100 - adaptivePercentile)%
+    uchar adaptiveMinThreshold = 100;   // 自适应阈值下限，同时作为候选点的预筛阈值
+
+    // 鲁棒拟合（仅 fitMode == RANSAC 时生效）
+    LaserFitMode fitMode = LaserFitMode::LEAST_SQUARES;
+    int ransacMaxIterations = 200;      // 迭代次数上限
+    int ransacTimeBudgetUs = 2000;      // 时间预算（微秒），超时即停止
+    float ransacInlierDistance = 2.0f;  // 内点到直线的最大距离（像素）
+    float ransacTargetInlierRatio = 0.9f; // 内点比例达到后提前结束
+    int ransacMaxSamples = 2048;        // 参与RANSAC的抽样点上限
+
+    // 粗到细搜索：先在按 pyramidFactor 抽样的网格上定位激光带，只对带内行做全分辨率扫描
+    int pyramidFactor = 1;              // 1:关闭 2/4:抽样倍率
+    int pyramidMargin = 4;              // 激光带上下额外保留的行数
+
+    // 稀疏预扫描：每 prescanRowStep 行、每 prescanColStep 列取一个像素，命中数不足 prescanMinHits 即判定为空帧，
+    // 直接返回 NOT_FOUND，不再扫描其余像素。近水平激光线的 prescanRowStep 不应大于线宽
+    bool prescanEnabled = false;
+    int prescanRowStep = 2;
+    int prescanColStep = 16;
+    int prescanMinHits = 3;
+    bool prescanSaveImage = false;      // 预扫描拒绝时是否仍保存失败结果图
+
+    // 帧间跟踪：只在上一帧直线附近 trackingBandHeight 行的带内搜索，未命中自动回退到整个ROI
+    bool trackingEnabled = false;
+    int trackingBandHeight = 32;
+
+    // 行带并行：ROI按固定行数 bandRows 切分（与线程数无关），各行带独立累加后按行带顺序归并，
+    // 结果与线程数无关、逐位一致；workerPool 为空时单线程顺序扫描
+    LaserWorkerPool* workerPool = nullptr;
+    int bandRows = 32;
+
+    // 结果图输出：为空时在检测线程同步写盘，否则交给异步写盘器，检测立即返回预留的路径
+    // （异步时写盘失败不再反映到本帧结果，见 DetectionResultCode::IMAGE_SAVE_FAILED）
+    ArtifactWriter* artifactWriter = nullptr;
+
+    // 结果图保存策略；artifactBudget 为空时不做抽样与限速（sampleEvery/maxPerMinute 不生效）
+    LaserArtifactPolicy artifactPolicy;
+    ArtifactBudget* artifactBudget = nullptr;
+
+    // 飞行记录：每个进入完整检测的ROI写入一条记录；flightDumpWindow > 0 时检测失败把最近窗口转存到输出目录，
+    // 两次失败转存之间至少间隔 flightDumpWindow 条新记录，避免连续失败时反复转存
+    FlightRecorder* flightRecorder = nullptr;
+    int flightDumpWindow = 0;
+
+    // 会话视频输出：非空时结果图追加到会话视频而不是单独的图像文件（保存策略仍然生效）
+    SessionVideoSink* videoSink = nullptr;
+
+    // 输出目录保留策略：非空时每个写出的结果图、飞行记录转存都登记到台账
+    RetentionManager* retention = nullptr;
+
+    // 检测会话的复用缓冲：非空时各ROI的累加器、行缓冲与行带部分累加器跨帧复用，稳态下检测不再申请堆内存；
+    // 为空时每次检测临时分配。同一缓冲区同一时刻只能服务一次检测
+    LaserScratchArena* scratch = nullptr;
+
+    // 实例日志（按相机ID区分，见 CLidarLineDetector::setCameraId）；为空时写入共享的 log/lidar_line_detection.log
+    spdlog::logger* logger = nullptr;
+};
+
+// 帧间跟踪状态（由调用方持有，如 CLidarLineDetector 实例），坐标均为ROI坐标
+struct LaserTrackingState {
+    bool valid = false;
+    int roiX = 0, roiY = 0, roiWidth = 0, roiHeight = 0; // 记录对应的ROI，ROI变化即失效
+    int lineTop = 0;    // 上一帧直线段覆盖的行范围
+    int lineBottom = 0;
+    uint64_t hits = 0;  // 跟踪命中/丢失次数
+    uint64_t misses = 0;
+};
+
+// 激光点集合（结构体数组形式，x/y分开存储，按ROI面积一次性预分配）
+struct LaserPointSet {
+    std::unique_ptr<int[]> xs;
+    std::unique_ptr<int[]> ys;
+    size_t count = 0;
+    size_t capacity = 0;
+
+    void reserve(size_t n); // 仅在容量不足时重新分配，不做清零
+};
+
+// 激光线流式拟合累加器：阈值扫描时逐行累加一阶/二阶矩，不保存点集
+// 阈值模式：rowMinX/rowMaxX 记录每行命中点的最左/最右x（无命中为-1），投影长度只需遍历ROI行数
+// 列模式：扫描时累加每列统计量，finishLaserScan 求出每列中心 colCenterY（无为-1）后再累加矩
+struct LaserLineAccumulator {
+    double n = 0, sx = 0, sy = 0, sxx = 0, sxy = 0, syy = 0;
+    std::vector<int> rowMinX;
+    std::vector<int> rowMaxX;
+    std::vector<int64_t> colWeight;  // 每列 (强度 - 阈值) 之和
+    std::vector<int64_t> colWeightY; // 每列 (强度 - 阈值) * y 之和
+    std::vector<uchar> colPeak;      // 每列峰值强度及所在行
+    std::vector<int> colPeakY;
+    std::vector<float> colCenterY;
+    // 本次扫描实际使用的阈值；自适应模式下另保存扫描区域的强度直方图与高于下限的候选点（按行分段）。
+    // 每行最多存 candStride = max(列数/8, 64) 个候选点（约 0.4 字节/像素，4K ROI 约 3MB），
+    // 超出的行记为 -1，回放时重新读取该行像素，结果相同
+    int threshold = 0;
+    std::vector<uint32_t> histogram;
+    std::vector<uint16_t> candX;
+    std::vector<uchar> candV;
+    std::vector<int> candRowCount;   // 每行候选点数（-1 为超出容量），第 r 行候选点从 r * candStride 处开始存放
+    int candStride = 0;
+    // RANSAC抽样点：保留坐标散列值是步长整数倍的点，满了就把步长翻倍并重新筛选；点集只取决于全部点的坐标，
+    // 与扫描顺序、行带划分无关，结果确定且数量有界
+    std::vector<cv::Point2f> sample;
+    size_t sampleCapacity = 0;
+    size_t sampleStride = 1;
+    // 扫描用的复用缓冲：行缓冲、每行命中点x、4组子直方图，以及行带并行时各行带的部分累加器
+    std::vector<uchar> rowBuf;
+    std::vector<int> rowXs;
+    std::vector<uint32_t> subHist;
+    std::vector<LaserLineAccumulator> bands;
+    std::vector<size_t> bandTotals;
+
+    // 按 rows x cols 的ROI与 options 预留全部缓冲（含行带部分累加器），之后同尺寸的扫描只复用不分配
+    void reserve(int rows, int cols, const LaserDetectionOptions& options);
+    void reset(int rows, int cols, LaserExtractionMode mode, size_t sampleCapacity = 0);
+    void add(double x, double y);
+    void addSample(float x, float y);
+    // 按行带顺序归并一个行带 [rowBegin, rowEnd) 的部分累加结果（part 与本累加器同尺寸同模式）
+    void merge(const LaserLineAccumulator& part, int rowBegin, int rowEnd);
+};
+
+// 检测会话的复用缓冲区（由 CLidarLineDetector 持有，按配置的ROI预分配）
+// 第 i 个ROI使用 accumulators[i]，单ROI检测使用第0个；intensity 为多ROI重叠时共享的强度平面
+struct LaserScratchArena {
+    std::vector<LaserLineAccumulator> accumulators;
+    cv::Mat intensity;
+
+    void reserve(const std::vector<ROI>& rois, const LaserDetectionOptions& options);
+};
+
+// 直线拟合结果（ROI坐标）
+struct LaserLineFit {
+    cv::Vec4f line;  // [vx, vy, x0, y0]
+    size_t count;    // 参与拟合的点数
+    double rms;      // 点到直线距离的均方根
+    double minProj;  // 点在直线方向上投影的最小/最大值
+    double maxProj;
+    int inliers;     // 最终拟合使用的内点数
+    int iterations;  // 迭代次数（最小二乘为1）
+};
+
 // 版本信息函数 - 移至命名空间内
 VersionInfo getVersionInfo();
 const char* getVersionString();
 int getVersionMajor();
 int getVersionMinor();
 int getVersionPatch();
+// 堆分配计数（经全局 operator new 的次数），以 LIDAR_COUNT_ALLOCATIONS 编译时有效，否则返回 -1；
+// 用于验证预热后每帧检测不再申请堆内存。OpenCV 的 Mat 缓冲不经 operator new，不在统计内
+long long allocationCount();
+// 按相机ID取得实例日志（log/lidar_<相机ID>.log，字母、数字、'-'、'_' 以外的字节转义为 %XX），同一ID返回同一日志对象，不同ID不会共用日志
+std::shared_ptr<spdlog::logger> cameraLogger(const std::string& cameraId);
 
 // 激光线检测相关函数声明
 DetectionResultCode readROIFromConfig(const std::string& configPath, ROI& roi);
-std::string generateFileName(const std::string& basePath, const std::string& sn);
+DetectionResultCode readROIsFromConfig(const std::string& configPath, std::vector<ROI>& rois); // 多组 x/y/width/height 依次排列
+// 生成结果文件名：basePath 为 <目录>/<前缀>，结果为 <目录>/<YYYYMMDD>/<HH>/<前缀>_<SN>_<YYYYMMDD_HHMMSS_微秒>_<序号><扩展名>
+// 序号在进程内单调递增，同一微秒内生成的名称也不重复；分片目录在首次使用时创建一次，之后不再访问文件系统
+std::string generateFileName(const std::string& basePath, const std::string& sn, const std::string& extension = ".jpg");
+void forgetArtifactShards(); // 分片目录被外部删除后调用，下次命名时重新创建
 LidarDetectionResult detectLidarLine(const cv::Mat& image, const ROI& roi, const std::string& sn, const std::string& outputDir);
+LidarDetectionResult detectLidarLine(const cv::Mat& image, const ROI& roi, const std::string& sn, const std::string& outputDir, const LaserDetectionOptions& options, LaserTrackingState* tracking = nullptr);
 LidarLineResult detect(const cv::Mat& image, const ROI& roi, const std::string& sn, const std::string& outputDir);
+LidarLineResult detect(const cv::Mat& image, const ROI& roi, const std::string& sn, const std::string& outputDir, const LaserDetectionOptions& options, LaserTrackingState* tracking = nullptr);
+// 多ROI检测：一次调用返回每个ROI的结果（顺序与rois一致），各ROI并行处理，汇总结果图只保存一张
+// tracking 非空时按下标为每个ROI保留一个帧间跟踪状态（不足时补齐），options.trackingEnabled 时生效
+std::vector<LidarDetectionResult> detectLidarLines(const cv::Mat& image, const std::vector<ROI>& rois, const std::string& sn, const std::string& outputDir, const LaserDetectionOptions& options,
+                                                   std::vector<LaserTrackingState>* tracking = nullptr);
+
+// 激光线检测底层内核（laser_line_kernels.cpp）
+// 支持 CV_8UC1/CV_8UC3/CV_8UC4，彩色图像逐行就地计算强度，不生成灰度图；阈值比较使用SSE2/AVX2
+bool isSupportedLaserImageType(int type);
+LaserPixelFormat resolveLaserPixelFormat(int type, LaserBayerPattern bayerPattern);
+// 将视图整体换算为 CV_8UC1 强度平面（多ROI重叠时共享一次换算）；8位单通道输入直接引用原数据
+void computeLaserIntensity(const cv::Mat& view, const LaserDetectionOptions& options, cv::Mat& intensity);
+// 任意支持格式转为8位灰度/BGR（标靶检测与结果图绘制使用），Bayer图像按 bayerPattern 去马赛克，
+// 16位图像与检测内核相同取 v >> mono16Shift（饱和到255）
+bool convertToGray(const cv::Mat& image, LaserBayerPattern bayerPattern, cv::Mat& gray, int mono16Shift = 8);
+bool convertToBGR(const cv::Mat& image, LaserBayerPattern bayerPattern, cv::Mat& bgr, int mono16Shift = 8);
+// 整图排列为 pattern 时，以 (x, y) 为左上角的子图自身的Bayer排列
+LaserBayerPattern bayerPatternAt(LaserBayerPattern pattern, int x, int y);
+// 提取ROI视图中所有强度 > threshold 的像素坐标，按行优先顺序写入points（仅用于调试图绘制）
+size_t extractLaserPoints(const cv::Mat& roiView, const LaserDetectionOptions& options, uchar threshold, LaserPointSet& points);
+// 扫描ROI视图的[rowBegin, rowEnd)行，按 options.extractionMode 把强度 > threshold 的像素累加进acc（y为ROI坐标）
+size_t scanLaserLine(const cv::Mat& roiView, int rowBegin, int rowEnd, const LaserDetectionOptions& options, LaserLineAccumulator& acc);
+// 由强度直方图（256档）按 options 的百分位/Otsu规则选取阈值，结果不低于 adaptiveMinThreshold
+uchar selectLaserThreshold(const std::vector<uint32_t>& histogram, const LaserDetectionOptions& options);
+// 稀疏预扫描：按 prescanRowStep/prescanColStep 抽样，命中 prescanMinHits 个即返回true（提前结束）
+bool prescanLaserEvidence(const cv::Mat& roiView, const LaserDetectionOptions& options);
+// 在粗网格（每 pyramidFactor 行/列取一个像素）上定位激光带，输出需精细扫描的行范围；粗网格无命中时返回false
+bool locateLaserBand(const cv::Mat& roiView, const LaserDetectionOptions& options, int& rowBegin, int& rowEnd);
+// 扫描结束后调用：列模式下求每列亚像素中心并累加矩（每列至多一点），返回参与拟合的点数
+size_t finishLaserScan(const cv::Mat& roiView, const LaserDetectionOptions& options, LaserLineAccumulator& acc);
+// 由累加矩闭式求解主方向（与 cv::fitLine(DIST_L2) 同一公式，整数坐标的矩在double下精确累加，
+// 角度与 fitLine 的差异仅为float舍入，< 1e-6 rad），RMS由同一组矩得到，投影范围由每行端点求得
+bool solveLaserLine(const LaserLineAccumulator& acc, LaserLineFit& fit);
+// 在acc的抽样点上做RANSAC：迭代次数与耗时均有上限，内点比例达标即提前退出，最后对内点最小二乘
+// 阈值模式下内点数按抽样点统计；列模式下抽样点即全部列中心
+bool robustFitLaserLine(const LaserLineAccumulator& acc, const LaserDetectionOptions& options, LaserLineFit& fit);
 
 } // namespace LidarLineDetector
 
@@ -134,29 +712,110 @@ LidarLineResult detect(const cv::Mat& image, const ROI& roi, const std::string&
 namespace CameraStabilityDetection {
     // 相机自检相关函数声明
     DetectionResultCode loadTargetConfig(const std::string& configPath, LidarLineDetector::TargetConfig& config);
-    DetectionResultCode detectTargetCenter(const cv::Mat& image, cv::Point2f& outCenter, cv::Mat& displayImage);
-    TargetMovementResult_C checkCameraMovement(const cv::Mat& image, const LidarLineDetector::TargetConfig& config, cv::Mat& displayImage);
+    // 支持8位单通道/BGR/BGRA、16位单通道，单通道原始Bayer图像需给出 bayerPattern，16位图像按 mono16Shift 换算（与激光检测一致）；
+    // logger 为空时写入共享的相机自检日志
+    DetectionResultCode detectTargetCenter(const cv::Mat& image, cv::Point2f& outCenter, cv::Mat& displayImage,
+                                           LidarLineDetector::LaserBayerPattern bayerPattern = LidarLineDetector::LaserBayerPattern::NONE,
+                                           int mono16Shift = 8, spdlog::logger* logger = nullptr);
+    // search/state 为空时整图搜索；给出 state 时整图搜索成功后学习标靶几何，search->windowed 时优先窗口搜索
+    TargetMovementResult_C checkCameraMovement(const cv::Mat& image, const LidarLineDetector::TargetConfig& config, cv::Mat& displayImage,
+                                               LidarLineDetector::LaserBayerPattern bayerPattern = LidarLineDetector::LaserBayerPattern::NONE,
+                                               int mono16Shift = 8, spdlog::logger* logger = nullptr,
+                                               const LidarLineDetector::TargetSearchOptions* search = nullptr,
+                                               LidarLineDetector::TargetSearchState* state = nullptr);
+    // 参考频谱缓存文件：与标靶配置文件同目录的 target_reference.yml
+    std::string referencePathFor(const std::string& configPath);
+    // 由参考帧检测标靶中心并计算参考频谱；标靶检测失败时不修改 reference
+    DetectionResultCode captureReference(const cv::Mat& image, int downsample, LidarLineDetector::PhaseReference& reference,
+                                         LidarLineDetector::LaserBayerPattern bayerPattern = LidarLineDetector::LaserBayerPattern::NONE,
+                                         int mono16Shift = 8, spdlog::logger* logger = nullptr);
+    DetectionResultCode saveReference(const std::string& path, const LidarLineDetector::PhaseReference& reference);
+    DetectionResultCode loadReference(const std::string& path, LidarLineDetector::PhaseReference& reference);
 } // namespace CameraStabilityDetection
 
 // 封装类定义
+// 线程安全：不同实例可在不同线程上并发使用，检测路径上不共享可变状态——检测缓冲、行带线程池、输出队列、飞行记录仪、
+// 会话视频均为实例独享，设置相机ID后检测与自检日志写入该相机自己的日志文件。进程级共享的只有结果文件命名序号
+// （原子计数）、分片目录缓存（加锁，只在新建目录时访问）与输出组件各自的日志。同一实例的方法不可在多个线程上同时调用
 class CLidarLineDetector {
 private:
     LidarLineDetector::ROI m_roi;
+    std::vector<LidarLineDetector::ROI> m_rois; // 配置文件中的全部ROI，m_roi为第一个
     std::string m_sn, m_outputDir;
+    LidarLineDetector::LaserDetectionOptions m_options;
+    LidarLineDetector::LaserTrackingState m_tracking;
+    std::vector<LidarLineDetector::LaserTrackingState> m_multiTracking; // 多ROI检测时每个ROI一个跟踪状态
+    std::unique_ptr<LidarLineDetector::LaserWorkerPool> m_workers; // 实例独享的行带并行线程池
+    std::shared_ptr<LidarLineDetector::RetentionManager> m_retention;    // 输出目录保留策略（进程内按目录共享；先于各输出组件声明，最后释放）
+    std::shared_ptr<LidarLineDetector::RetentionManager> m_logRetention; // log 目录保留策略（进程内共享）
+    std::unique_ptr<LidarLineDetector::SessionVideoSink> m_video;   // 实例独享的会话视频（先于异步队列声明，队列析构写完剩余帧时仍有效）
+    std::unique_ptr<LidarLineDetector::ArtifactWriter> m_artifacts; // 实例独享的异步输出队列
+    LidarLineDetector::ArtifactBudget m_artifactBudget;             // 结果图抽样与限速状态
+    std::unique_ptr<LidarLineDetector::FlightRecorder> m_recorder;  // 实例独享的飞行记录仪
+    std::string m_recorderPath;                                      // 飞行记录环形文件，保留策略不回收
+    std::unique_ptr<LidarLineDetector::LaserScratchArena> m_scratch; // 按ROI预分配的检测缓冲，稳态下每帧不再分配
+
+    std::string m_cameraId;
+    std::string m_targetConfigPath; // 最近一次读取的标靶配置文件，参考频谱缓存在其旁边
+    LidarLineDetector::TargetSearchOptions m_targetSearch; // 相机自检标靶搜索参数与学到的标靶几何
+    LidarLineDetector::TargetSearchState m_targetState;
+    std::shared_ptr<spdlog::logger> m_logger; // 按相机ID区分的实例日志，未设置相机ID时为空
+
+    void reserveScratch(); // ROI或影响缓冲尺寸的参数变化后重新预留
 
 public:
     CLidarLineDetector() = default;
-    ~CLidarLineDetector() = default;
+    ~CLidarLineDetector();
 
     DetectionResultCode initialize(const char* configPath);
     void setROI(int x, int y, int width, int height);
     void setSn(const char* sn);
+    // 相机ID：检测与自检日志写入 log/lidar_<相机ID>.log，日志名带相机ID；相同ID的实例共用同一日志，空串恢复共享日志
+    void setCameraId(const char* cameraId);
     void setOutputDir(const char* outputDir);
+    void setIntensityChannel(int channel);
+    void setLaserThreshold(int threshold);
+    void setExtractionMode(int mode);
+    void setRobustFit(int mode, int maxIterations, int timeBudgetUs, float inlierDistance, float targetInlierRatio);
+    void setPyramidSearch(int factor, int margin);
+    void setTracking(bool enabled, int bandHeight);
+    void setAdaptiveThreshold(int mode, float percentile, int minThreshold);
+    void setThreadCount(int threads); // <=0 关闭行带并行
+    void setPixelFormat(int bayerPattern, int mono16Shift); // 输入格式由图像 type 决定，此处补充Bayer排列与16位换算
+    void setPrescan(bool enabled, int rowStep, int colStep, int minHits, bool saveImage);
+    void setAsyncOutput(bool enabled, int queueCapacity, int overflowPolicy); // overflowPolicy 0:丢弃 1:阻塞
+    bool flushOutput(int timeoutMs); // timeoutMs<0 一直等待
+    TArtifactQueueStats_C getOutputStats() const;
+    // trigger 0:每帧 1:仅失败 2:不保存；format 0:JPEG 1:PNG，quality 为JPEG质量(0-100)或PNG压缩级别(0-9)
+    void setArtifactPolicy(int trigger, int sampleEvery, int maxPerMinute, bool cropToROI, float scale, int format, int quality);
+    // path 为空或 slotCount<=0 时关闭；slotBytes<=0 时按当前ROI面积x4字节；dumpWindow>0 时检测失败自动转存
+    bool setFlightRecorder(const char* path, int slotCount, int slotBytes, int dumpWindow);
+    int dumpFlightRecord(const char* dumpPath, int window); // 显式触发转存，返回写入条数
+    // 在输出目录下开启新的会话视频（须先设置输出目录与SN），enabled=false 时关闭并写完当前分段
+    bool setVideoOutput(bool enabled, int framesPerSegment, double fps);
+    // 输出目录与 log 目录的保留策略：quotaMB 总配额，maxAgeHours/failureMaxAgeHours 普通/失败文件最长保留小时数，0 不限。
+    // 同一目录的策略由各实例共享，最后一次设置生效；须在 setOutputDir 之后调用
+    void setRetention(bool enabled, long long quotaMB, int maxAgeHours, int failureMaxAgeHours);
+    TRetentionStats_C getRetentionStats() const;
     TLidarLineResult_C detect(const TCMat_C image);
+    int detectMulti(const TCMat_C image, const TROIConfig_C* rois, int roiCount, TLidarLineResult_C* results);
+    int detectAll(const TCMat_C image, TLidarLineResult_C* results, int maxResults); // 使用配置文件中的全部ROI
+    int getROICount() const;
     
     // 相机自检相关方法
     DetectionResultCode loadTargetConfig(const char* configPath, LidarLineDetector::TargetConfig& config);
     TargetMovementResult_C checkCameraStability(const TCMat_C image, const TTargetConfig_C config);
+    // windowed=true 时首次整图检测学到标靶几何后，只在预期方块位置附近搜索；windowMargin 为窗口外扩像素（<=0 不修改）
+    void setTargetSearch(bool windowed, int windowMargin);
+    // finder 0:轮廓 1:连通域；minFillRatio 为连通域引擎的填充率下限（(0,1]，否则不修改）
+    void setTargetFinder(int finder, float minFillRatio);
+    // 调试时采集参考帧：检测标靶中心、计算降采样参考频谱并写入 referencePath（为空时写到标靶配置文件旁）。
+    // loadTargetConfig 读取配置时自动加载其旁边已缓存的参考频谱
+    DetectionResultCode captureStabilityReference(const TCMat_C image, int downsample, const char* referencePath);
+    // enabled 时有参考频谱先做相位相关；escalateRatio、minResponse 在 (0,1] 内才修改
+    void setPhaseShiftCheck(bool enabled, float escalateRatio, float minResponse);
+    // enabled 时检测成功后逐帧跟踪四个方块；redetectEvery、trackMargin、maxTrackError 为正才修改
+    void setTargetTracking(bool enabled, int redetectEvery, int trackMargin, float maxTrackError);
     
     // 版本信息接口 - 添加导出标记
     static Smpclass_API VersionInfo getVersionInfo();
@@ -173,12 +832,47 @@ extern "C" {
     Smpclass_API DetectionResultCode CLidarLineDetector_initialize(CLidarLineDetector* instance, const char* configPath);
     Smpclass_API void CLidarLineDetector_setROI(CLidarLineDetector* instance, int x, int y, int width, int height);
     Smpclass_API void CLidarLineDetector_setSn(CLidarLineDetector* instance, const char* sn);
+    Smpclass_API void CLidarLineDetector_setCameraId(CLidarLineDetector* instance, const char* cameraId); // 实例日志按相机ID分文件
     Smpclass_API void CLidarLineDetector_setOutputDir(CLidarLineDetector* instance, const char* outputDir);
+    Smpclass_API void CLidarLineDetector_setIntensityChannel(CLidarLineDetector* instance, int channel); // 0:亮度 1:B 2:G 3:R
+    Smpclass_API void CLidarLineDetector_setLaserThreshold(CLidarLineDetector* instance, int threshold);
+    Smpclass_API void CLidarLineDetector_setExtractionMode(CLidarLineDetector* instance, int mode); // 0:阈值 1:列重心 2:列峰值插值
+    Smpclass_API void CLidarLineDetector_setPyramidSearch(CLidarLineDetector* instance, int factor, int margin); // factor 1:关闭 2/4:粗搜索倍率
+    Smpclass_API void CLidarLineDetector_setTracking(CLidarLineDetector* instance, int enabled, int bandHeight); // enabled 0:关闭 1:开启
+    Smpclass_API void CLidarLineDetector_setAsyncOutput(CLidarLineDetector* instance, int enabled, int queueCapacity, int overflowPolicy); // 异步写盘，overflowPolicy 0:丢弃 1:阻塞
+    Smpclass_API int CLidarLineDetector_flushOutput(CLidarLineDetector* instance, int timeoutMs); // 等待异步队列写空，成功返回1，超时返回0
+    Smpclass_API TArtifactQueueStats_C CLidarLineDetector_getOutputStats(CLidarLineDetector* instance);
+    // 飞行记录仪：最近 slotCount 条原始ROI帧写入内存映射环形文件，成功返回1
+    Smpclass_API int CLidarLineDetector_setFlightRecorder(CLidarLineDetector* instance, const char* path, int slotCount, int slotBytes, int dumpWindow);
+    Smpclass_API int CLidarLineDetector_dumpFlightRecord(CLidarLineDetector* instance, const char* dumpPath, int window);
+    // 会话视频：结果图追加到输出目录下分段的MJPEG/AVI文件，成功返回1
+    Smpclass_API int CLidarLineDetector_setVideoOutput(CLidarLineDetector* instance, int enabled, int framesPerSegment, double fps);
+    // 输出目录保留策略：后台按配额(MB)与保留时间(小时)删除旧文件，失败图像优先保留
+    Smpclass_API void CLidarLineDetector_setRetention(CLidarLineDetector* instance, int enabled, long long quotaMB, int maxAgeHours, int failureMaxAgeHours);
+    Smpclass_API TRetentionStats_C CLidarLineDetector_getRetentionStats(CLidarLineDetector* instance);
+    // 结果图保存策略：trigger 0:每帧 1:仅失败 2:不保存；sampleEvery 每N帧保存一帧；maxPerMinute 0:不限；
+    // cropToROI 1:只保存ROI附近区域；scale 缩略图比例；format 0:JPEG 1:PNG；quality JPEG质量或PNG压缩级别
+    Smpclass_API void CLidarLineDetector_setArtifactPolicy(CLidarLineDetector* instance, int trigger, int sampleEvery, int maxPerMinute, int cropToROI, float scale, int format, int quality);
+    Smpclass_API void CLidarLineDetector_setPrescan(CLidarLineDetector* instance, int enabled, int rowStep, int colStep, int minHits, int saveImage); // 空帧快速拒绝
+    Smpclass_API void CLidarLineDetector_setPixelFormat(CLidarLineDetector* instance, int bayerPattern, int mono16Shift); // bayerPattern 0:非Bayer 1:RGGB 2:BGGR 3:GRBG 4:GBRG
+    Smpclass_API void CLidarLineDetector_setThreadCount(CLidarLineDetector* instance, int threads); // 单帧行带并行线程数，<=0 关闭
+    Smpclass_API void CLidarLineDetector_setAdaptiveThreshold(CLidarLineDetector* instance, int mode, float percentile, int minThreshold); // mode 0:固定 1:百分位 2:Otsu
+    Smpclass_API void CLidarLineDetector_setRobustFit(CLidarLineDetector* instance, int mode, int maxIterations, int timeBudgetUs, float inlierDistance, float targetInlierRatio); // mode 0:最小二乘 1:RANSAC
     Smpclass_API TLidarLineResult_C CLidarLineDetector_detect(CLidarLineDetector* instance, const TCMat_C image);
+    // 多ROI检测：results 需至少容纳 roiCount 个元素，返回写入的结果数
+    Smpclass_API int CLidarLineDetector_detectMulti(CLidarLineDetector* instance, const TCMat_C image, const TROIConfig_C* rois, int roiCount, TLidarLineResult_C* results);
+    Smpclass_API int CLidarLineDetector_detectAll(CLidarLineDetector* instance, const TCMat_C image, TLidarLineResult_C* results, int maxResults);
+    Smpclass_API int CLidarLineDetector_getROICount(CLidarLineDetector* instance);
     
     // 相机自检相关C接口
     Smpclass_API DetectionResultCode CLidarLineDetector_loadTargetConfig(CLidarLineDetector* instance, const char* configPath, TTargetConfig_C* config);
     Smpclass_API TargetMovementResult_C CLidarLineDetector_checkCameraStability(CLidarLineDetector* instance, const TCMat_C image, const TTargetConfig_C config);
+    Smpclass_API void CLidarLineDetector_setTargetSearch(CLidarLineDetector* instance, int windowed, int windowMargin); // 标靶窗口搜索，windowed 0:整图 1:窗口
+    Smpclass_API void CLidarLineDetector_setTargetFinder(CLidarLineDetector* instance, int finder, float minFillRatio); // 标靶查找引擎 0:轮廓 1:连通域
+    // 采集相位相关参考帧，referencePath 为空时写到标靶配置文件旁的 target_reference.yml
+    Smpclass_API DetectionResultCode CLidarLineDetector_captureStabilityReference(CLidarLineDetector* instance, const TCMat_C image, int downsample, const char* referencePath);
+    Smpclass_API void CLidarLineDetector_setPhaseShiftCheck(CLidarLineDetector* instance, int enabled, float escalateRatio, float minResponse); // 相位相关快速自检
+    Smpclass_API void CLidarLineDetector_setTargetTracking(CLidarLineDetector* instance, int enabled, int redetectEvery, int trackMargin, float maxTrackError); // 标靶方块逐帧跟踪
     
     // 版本信息C接口
     Smpclass_API VersionInfo LidarLineDetector_GetVersionInfo();
@@ -186,6 +880,7 @@ extern "C" {
     Smpclass_API int LidarLineDetector_GetVersionMajor();
     Smpclass_API int LidarLineDetector_GetVersionMinor();
     Smpclass_API int LidarLineDetector_GetVersionPatch();
+    Smpclass_API long long LidarLineDetector_GetAllocationCount(); // 未启用分配计数时返回 -1
 }
 
 #endif // LIDAR_LINE_DETECTION_H    
\ No newline at end of file
@@ -0,0 +1,60 @@
+#include "lidar_line_detection.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// 堆分配计数：以 LIDAR_COUNT_ALLOCATIONS 编译时替换全局 operator new/delete，统计经 operator new 的分配次数。
+// Windows 下替换只作用于本动态库自身的分配；Linux 下作用于整个进程（调用方的分配同样计入，测量时应只包住检测调用）
+namespace LidarLineDetector {
+
+    static std::atomic<unsigned long long> allocations{0};
+
+    long long allocationCount()
+    {
+#ifdef LIDAR_COUNT_ALLOCATIONS
+        return static_cast<long long>(allocations.load(std::memory_order_relaxed));
+#else
+        return -1;
+#endif
+    }
+
+#ifdef LIDAR_COUNT_ALLOCATIONS
+    static void* countedAlloc(std::size_t size) noexcept
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        return std::malloc(size != 0 ? size : 1);
+    }
+#endif
+
+} // namespace LidarLineDetector
+
+#ifdef LIDAR_COUNT_ALLOCATIONS
+void* operator new(std::size_t size)
+{
+    if (void* p = LidarLineDetector::countedAlloc(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return ::operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return LidarLineDetector::countedAlloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return LidarLineDetector::countedAlloc(size);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+#endif
@@ -0,0 +1,72 @@
+#include "lidar_line_detection.h"
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <ctime>
+#include <cstdio>
+#include <filesystem>
+#include <unordered_set>
+
+// 结果文件命名：按日期/小时分目录，微秒时间戳加进程内序号保证不重名
+namespace LidarLineDetector {
+
+    static std::atomic<uint64_t> artifactSequence{0};
+    static std::mutex shardMutex;
+    static std::unordered_set<std::string> createdShards; // 已创建的分片目录，每个分片只创建一次
+
+    static void toLocalTime(time_t t, std::tm& out)
+    {
+#ifdef _WIN32
+        localtime_s(&out, &t);
+#else
+        localtime_r(&t, &out);
+#endif
+    }
+
+    static void ensureShardDirectory(const std::string& shard)
+    {
+        std::lock_guard<std::mutex> lock(shardMutex);
+        if (createdShards.count(shard))
+            return;
+        std::error_code ec;
+        std::filesystem::create_directories(shard, ec);
+        // 创建失败时不记入缓存，下次调用重试；写文件时由调用方报告失败
+        if (!ec)
+            createdShards.insert(shard);
+    }
+
+    void forgetArtifactShards()
+    {
+        std::lock_guard<std::mutex> lock(shardMutex);
+        createdShards.clear();
+    }
+
+    std::string generateFileName(const std::string& basePath, const std::string& sn, const std::string& extension)
+    {
+        const auto now = std::chrono::system_clock::now();
+        const time_t seconds = std::chrono::system_clock::to_time_t(now);
+        const long long micros = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count() % 1000000;
+        std::tm local = {};
+        toLocalTime(seconds, local);
+        const unsigned long long sequence = ++artifactSequence;
+
+        // basePath 形如 <目录>/<前缀>，分片目录插在两者之间
+        const size_t slash = basePath.find_last_of("/\\");
+        const std::string directory = slash == std::string::npos ? std::string(".") : basePath.substr(0, slash);
+        const std::string stem = slash == std::string::npos ? basePath : basePath.substr(slash + 1);
+
+        char shard[32];
+        std::snprintf(shard, sizeof(shard), "/%04d%02d%02d/%02d", local.tm_year + 1900, local.tm_mon + 1, local.tm_mday, local.tm_hour);
+        char stamp[64];
+        std::snprintf(stamp, sizeof(stamp), "_%04d%02d%02d_%02d%02d%02d_%06lld_%llu", local.tm_year + 1900, local.tm_mon + 1, local.tm_mday,
+                      local.tm_hour, local.tm_min, local.tm_sec, micros, sequence);
+
+        std::string shardPath = directory + shard;
+        ensureShardDirectory(shardPath);
+        std::string name;
+        name.reserve(shardPath.size() + stem.size() + sn.size() + extension.size() + 40);
+        name.append(shardPath).append("/").append(stem).append("_").append(sn).append(stamp).append(extension);
+        return name;
+    }
+
+} // namespace LidarLineDetector
@@ -0,0 +1,207 @@
+#include "lidar_line_detection.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <chrono>
+#include <algorithm>
+#include "spdlog/spdlog.h"
+#include "spdlog/sinks/basic_file_sink.h"
+
+// 结果图异步写盘与抽样限速
+namespace LidarLineDetector {
+
+    static std::shared_ptr<spdlog::logger> logger = spdlog::basic_logger_mt("artifact_logger", "log/artifact_writer.log");
+
+    struct ArtifactWriter::Impl {
+        struct Job {
+            cv::Mat* buffer;
+            std::string path; // 会话视频时为SN
+            std::vector<int> params;
+            SessionVideoSink* sink;
+            RetentionManager* retention; // 写盘成功后登记，保证台账中的文件都已落盘
+            bool failure;
+        };
+
+        OverflowPolicy policy;
+        std::vector<std::unique_ptr<cv::Mat>> buffers; // 缓冲池，Mat 尺寸不变时反复复用同一块内存
+        std::vector<cv::Mat*> freeBuffers;
+        std::deque<Job> queue;
+        int writing = 0;
+        bool stop = false;
+        Stats stats;
+        mutable std::mutex mutex;
+        std::condition_variable jobReady;  // 有新任务或退出
+        std::condition_variable bufferFree; // 有缓冲归还或队列写空
+        std::thread worker;
+
+        void enqueue(Job job);
+
+        void run()
+        {
+            for (;;) {
+                Job job;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    jobReady.wait(lock, [&] { return stop || !queue.empty(); });
+                    if (queue.empty())
+                        return; // stop 且队列已写空
+                    job = std::move(queue.front());
+                    queue.pop_front();
+                    ++writing;
+                }
+                bool ok = false;
+                try {
+                    std::string location;
+                    ok = job.sink != nullptr ? job.sink->append(*job.buffer, job.path, location)
+                                             : cv::imwrite(job.path, *job.buffer, job.params);
+                } catch (const cv::Exception& e) {
+                    logger->error("编码图像异常: {} ({})", job.path, e.what());
+                }
+                if (!ok)
+                    logger->error("保存图像失败: {}", job.path);
+                else if (job.retention != nullptr)
+                    job.retention->track(job.path, job.failure);
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    --writing;
+                    ++(ok ? stats.written : stats.failed);
+                    --stats.pending;
+                    freeBuffers.push_back(job.buffer);
+                }
+                bufferFree.notify_all();
+            }
+        }
+    };
+
+    ArtifactWriter::ArtifactWriter(int capacity, OverflowPolicy policy) : m_impl(new Impl)
+    {
+        m_impl->policy = policy;
+        capacity = std::max(capacity, 1);
+        for (int i = 0; i < capacity; ++i) {
+            m_impl->buffers.emplace_back(new cv::Mat);
+            m_impl->freeBuffers.push_back(m_impl->buffers.back().get());
+        }
+        m_impl->worker = std::thread([this] { m_impl->run(); });
+    }
+
+    ArtifactWriter::~ArtifactWriter()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_impl->mutex);
+            m_impl->stop = true;
+        }
+        m_impl->jobReady.notify_all();
+        m_impl->worker.join();
+    }
+
+    cv::Mat* ArtifactWriter::acquire()
+    {
+        Impl& impl = *m_impl;
+        std::unique_lock<std::mutex> lock(impl.mutex);
+        if (impl.freeBuffers.empty()) {
+            if (impl.policy == OverflowPolicy::DROP) {
+                ++impl.stats.dropped;
+                return nullptr;
+            }
+            impl.bufferFree.wait(lock, [&] { return !impl.freeBuffers.empty(); });
+        }
+        cv::Mat* buffer = impl.freeBuffers.back();
+        impl.freeBuffers.pop_back();
+        return buffer;
+    }
+
+    void ArtifactWriter::submit(cv::Mat* buffer, const std::string& path, const std::vector<int>& params,
+                                RetentionManager* retention, bool failure)
+    {
+        m_impl->enqueue(Impl::Job{buffer, path, params, nullptr, retention, failure});
+    }
+
+    void ArtifactWriter::submit(cv::Mat* buffer, SessionVideoSink* sink, const std::string& sn)
+    {
+        m_impl->enqueue(Impl::Job{buffer, sn, std::vector<int>(), sink, nullptr, false});
+    }
+
+    void ArtifactWriter::Impl::enqueue(Job job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push_back(std::move(job));
+            ++stats.submitted;
+            ++stats.pending;
+            stats.peakPending = std::max(stats.peakPending, stats.pending);
+        }
+        jobReady.notify_one();
+    }
+
+    void ArtifactWriter::release(cv::Mat* buffer)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_impl->mutex);
+            m_impl->freeBuffers.push_back(buffer);
+        }
+        m_impl->bufferFree.notify_all();
+    }
+
+    bool ArtifactWriter::flush(int timeoutMs)
+    {
+        Impl& impl = *m_impl;
+        std::unique_lock<std::mutex> lock(impl.mutex);
+        auto drained = [&] { return impl.queue.empty() && impl.writing == 0; };
+        if (timeoutMs < 0) {
+            impl.bufferFree.wait(lock, drained);
+            return true;
+        }
+        return impl.bufferFree.wait_for(lock, std::chrono::milliseconds(timeoutMs), drained);
+    }
+
+    ArtifactWriter::Stats ArtifactWriter::stats() const
+    {
+        std::lock_guard<std::mutex> lock(m_impl->mutex);
+        return m_impl->stats;
+    }
+
+    struct ArtifactBudget::Impl {
+        std::mutex mutex;
+        uint64_t frames = 0;
+        double tokens = -1.0; // <0 表示尚未初始化，首次使用时补满
+        std::chrono::steady_clock::time_point last;
+    };
+
+    ArtifactBudget::ArtifactBudget() : m_impl(new Impl) {}
+
+    ArtifactBudget::~ArtifactBudget() = default;
+
+    bool ArtifactBudget::admit(const LaserArtifactPolicy& policy)
+    {
+        Impl& impl = *m_impl;
+        std::lock_guard<std::mutex> lock(impl.mutex);
+        if (policy.sampleEvery > 1 && impl.frames++ % policy.sampleEvery != 0)
+            return false;
+        if (policy.maxPerMinute <= 0)
+            return true;
+
+        // 令牌桶：容量为每分钟上限，按 maxPerMinute/60 每秒匀速补充
+        const double capacity = policy.maxPerMinute;
+        auto now = std::chrono::steady_clock::now();
+        if (impl.tokens < 0.0)
+            impl.tokens = capacity;
+        else
+            impl.tokens = std::min(capacity, impl.tokens + std::chrono::duration<double>(now - impl.last).count() * capacity / 60.0);
+        impl.last = now;
+        if (impl.tokens < 1.0) {
+            logger->debug("结果图超出每分钟上限 {}，本帧不保存", policy.maxPerMinute);
+            return false;
+        }
+        impl.tokens -= 1.0;
+        return true;
+    }
+
+    void ArtifactBudget::reset()
+    {
+        std::lock_guard<std::mutex> lock(m_impl->mutex);
+        m_impl->frames = 0;
+        m_impl->tokens = -1.0;
+    }
+
+} // namespace LidarLineDetector
@@ -13,6 +13,12 @@ namespace CameraStabilityDetection {
 
     static std::shared_ptr<spdlog::logger> logger = spdlog::basic_logger_mt("camera_logger", "log/camera_stability_detection.log");
 
+    // 自检日志：调用方给出实例日志（按相机ID区分）时写入实例日志，否则写入共享日志
+    static spdlog::logger& logOf(spdlog::logger* instanceLogger)
+    {
+        return instanceLogger != nullptr ? *instanceLogger : *logger;
+    }
+
     // 标靶配置文件 读取
     DetectionResultCode loadTargetConfig(const string &configPath, LidarLineDetector::TargetConfig &config)
     {
@@ -78,116 +84,661 @@ namespace CameraStabilityDetection {
         }
     }
 
-    // 检测标靶四个角落的黑色方块
-    bool detectTarget(const Mat& image, vector<Point2f>& corners, Mat& displayImage) {
-        logger->info("开始检测标靶四个角落的黑色方块");
-        Mat gray, binary;
-        cvtColor(image, gray, COLOR_BGR2GRAY);
+    using LidarLineDetector::TargetSquare;
+    using LidarLineDetector::TargetSearchScratch;
+
+    // 一次标靶检测的结果记录：检测阶段只填写记录，不碰显示图像；需要显示图像时由 renderTargetOverlay 统一绘制。
+    // 方块存放在调用方给出的容器中（有搜索状态时为其工作缓冲），逐帧复用
+    struct TargetObservation {
+        explicit TargetObservation(vector<TargetSquare>& storage) : squares(storage) { squares.clear(); }
+        vector<TargetSquare>& squares; // 找到的方块（检测失败时为实际找到的全部候选，跟踪/窗口命中时为四个方块）
+        bool located = false;          // 得到标靶中心
+        Point2f center;
+    };
+
+    // 换算到复用的灰度缓冲。单通道8位输入时 convertToGray 直接给出输入的视图：先丢弃上一次留下的外部视图，
+    // 避免之后按尺寸复用缓冲的颜色转换写进调用方的图像
+    static bool grayInto(const Mat& image, LidarLineDetector::LaserBayerPattern bayerPattern, int mono16Shift, Mat& gray)
+    {
+        if (gray.u == nullptr || gray.u->refcount > 1)
+            gray.release();
+        return LidarLineDetector::convertToGray(image, bayerPattern, gray, mono16Shift);
+    }
+
+    // 轮廓引擎：二值化、开闭运算去噪后取面积、凸四边形与长宽比符合的轮廓
+    static void findSquaresByContours(const Mat& gray, const Point& origin, TargetSearchScratch& scratch, vector<TargetSquare>& squares)
+    {
+        Mat& binary = scratch.binary;
         threshold(gray, binary, 80, 255, THRESH_BINARY_INV);
-        
+
         // 形态学操作去噪
-        Mat kernel = getStructuringElement(MORPH_RECT, Size(5, 5));
-        morphologyEx(binary, binary, MORPH_OPEN, kernel);
-        morphologyEx(binary, binary, MORPH_CLOSE, kernel);
-        
-        vector<vector<Point>> contours;
-        findContours(binary, contours, RETR_EXTERNAL, CHAIN_APPROX_SIMPLE);
-        
-        vector<Point2f> centers;
-        for (const auto& contour : contours) {
+        if (scratch.kernel.empty())
+            scratch.kernel = getStructuringElement(MORPH_RECT, Size(5, 5));
+        morphologyEx(binary, binary, MORPH_OPEN, scratch.kernel);
+        morphologyEx(binary, binary, MORPH_CLOSE, scratch.kernel);
+
+        findContours(binary, scratch.contours, RETR_EXTERNAL, CHAIN_APPROX_SIMPLE);
+
+        vector<Point>& approx = scratch.approx;
+        for (const auto& contour : scratch.contours) {
             double area = contourArea(contour);
             if (area < 2000 || area > 50000) continue;
-            
-            vector<Point> approx;
+
             approxPolyDP(contour, approx, arcLength(contour, true) * 0.02, true);
             if (approx.size() == 4 && isContourConvex(approx)) {
                 Rect rect = boundingRect(approx);
                 double aspect = (double)rect.width / rect.height;
                 if (aspect > 0.7 && aspect < 1.3) {
                     Moments m = moments(contour);
-                    if (m.m00 != 0) {
-                        Point2f center(m.m10/m.m00, m.m01/m.m00);
-                        centers.push_back(center);
-                        // 在显示图像上绘制检测到的方块
-                        circle(displayImage, center, 8, Scalar(0, 255, 0), 2);
-                        rectangle(displayImage, rect, Scalar(0, 255, 0), 2);
-                    }
+                    if (m.m00 != 0)
+                        squares.push_back({Point2f(m.m10 / m.m00 + origin.x, m.m01 / m.m00 + origin.y), rect + origin});
                 }
             }
         }
-        
-        if (centers.size() != 4) {
-            logger->warn("未能检测到4个标靶方块，找到: {}", centers.size());
-            cv::putText(displayImage, "Target Detection Failed: " + std::to_string(centers.size()) + " targets found", 
-                       cv::Point(20, 30), cv::FONT_HERSHEY_SIMPLEX, 0.7, cv::Scalar(0, 0, 255), 2);
+    }
+
+    // 行方向滑窗：dst[x] 由 [x-radius, x+radius] 内（裁剪到行内）满足 isSet 的像素数决定，
+    // 腐蚀要求窗口内全部为前景，膨胀要求至少一个前景；图像外按 OpenCV 默认边界处理（腐蚀时视为前景，膨胀时视为背景）
+    template <class IsSet>
+    static void rankRow(int cols, int radius, bool erode, const IsSet& isSet, uchar* dst)
+    {
+        int count = 0;
+        for (int x = 0; x < std::min(radius, cols); ++x)
+            count += isSet(x);
+        for (int x = 0; x < cols; ++x) {
+            if (x + radius < cols)
+                count += isSet(x + radius);
+            if (x - radius - 1 >= 0)
+                count -= isSet(x - radius - 1);
+            const int len = std::min(x + radius, cols - 1) - std::max(x - radius, 0) + 1;
+            dst[x] = erode ? count == len : count > 0;
+        }
+    }
+
+    // 列方向滑窗：逐行增减每列计数，按行顺序访问内存
+    static void rankColumns(const Mat& src, int radius, bool erode, vector<int>& counts, Mat& dst)
+    {
+        const int rows = src.rows, cols = src.cols;
+        counts.assign(cols, 0);
+        for (int y = 0; y < std::min(radius, rows); ++y) {
+            const uchar* row = src.ptr<uchar>(y);
+            for (int x = 0; x < cols; ++x)
+                counts[x] += row[x];
+        }
+        for (int y = 0; y < rows; ++y) {
+            if (y + radius < rows) {
+                const uchar* add = src.ptr<uchar>(y + radius);
+                for (int x = 0; x < cols; ++x)
+                    counts[x] += add[x];
+            }
+            if (y - radius - 1 >= 0) {
+                const uchar* sub = src.ptr<uchar>(y - radius - 1);
+                for (int x = 0; x < cols; ++x)
+                    counts[x] -= sub[x];
+            }
+            const int len = std::min(y + radius, rows - 1) - std::max(y - radius, 0) + 1;
+            uchar* out = dst.ptr<uchar>(y);
+            for (int x = 0; x < cols; ++x)
+                out[x] = erode ? counts[x] == len : counts[x] > 0;
+        }
+    }
+
+    // 二值化与去噪合并：暗像素（<=80）为前景，5x5开运算后接5x5闭运算。矩形结构元下两次相邻膨胀等价于一次9x9膨胀，
+    // 因此整体等价于 腐蚀5 → 膨胀9 → 腐蚀5，每步拆成行、列两次滑窗计数，二值化在第一次行滑窗中完成，输出0/1
+    // 结果写入 scratch.binary（兼作中间缓冲），另一中间缓冲为 scratch.morph
+    static void thresholdAndClean(const Mat& gray, TargetSearchScratch& scratch)
+    {
+        const int rows = gray.rows, cols = gray.cols;
+        Mat& a = scratch.morph;
+        Mat& b = scratch.binary;
+        a.create(rows, cols, CV_8UC1);
+        b.create(rows, cols, CV_8UC1);
+        vector<int>& counts = scratch.counts;
+        for (int y = 0; y < rows; ++y) {
+            const uchar* g = gray.ptr<uchar>(y);
+            rankRow(cols, 2, true, [g](int x) { return g[x] <= 80 ? 1 : 0; }, a.ptr<uchar>(y));
+        }
+        rankColumns(a, 2, true, counts, b);
+        for (int y = 0; y < rows; ++y) {
+            const uchar* r = b.ptr<uchar>(y);
+            rankRow(cols, 4, false, [r](int x) { return static_cast<int>(r[x]); }, a.ptr<uchar>(y));
+        }
+        rankColumns(a, 4, false, counts, b);
+        for (int y = 0; y < rows; ++y) {
+            const uchar* r = b.ptr<uchar>(y);
+            rankRow(cols, 2, true, [r](int x) { return static_cast<int>(r[x]); }, a.ptr<uchar>(y));
+        }
+        rankColumns(a, 2, true, counts, b);
+    }
+
+    // 连通域引擎：一次标记得到每个连通域的面积、外接矩形与质心，方块判据直接作用于这些统计量：
+    // 面积与长宽比同轮廓引擎，填充率（面积/外接矩形面积）代替四边形近似与凸性检查
+    static void findSquaresByComponents(const Mat& gray, const Point& origin, float minFillRatio, TargetSearchScratch& scratch, vector<TargetSquare>& squares)
+    {
+        thresholdAndClean(gray, scratch);
+        const Mat& stats = scratch.stats;
+        const Mat& centroids = scratch.centroids;
+        const int count = connectedComponentsWithStats(scratch.binary, scratch.labels, scratch.stats, scratch.centroids, 8, CV_32S);
+        for (int i = 1; i < count; ++i) {
+            const int area = stats.at<int>(i, CC_STAT_AREA);
+            if (area < 2000 || area > 50000) continue;
+            Rect rect(stats.at<int>(i, CC_STAT_LEFT), stats.at<int>(i, CC_STAT_TOP), stats.at<int>(i, CC_STAT_WIDTH), stats.at<int>(i, CC_STAT_HEIGHT));
+            double aspect = (double)rect.width / rect.height;
+            if (aspect <= 0.7 || aspect >= 1.3) continue;
+            if (area < minFillRatio * rect.area()) continue;
+            squares.push_back({Point2f(static_cast<float>(centroids.at<double>(i, 0)) + origin.x, static_cast<float>(centroids.at<double>(i, 1)) + origin.y),
+                               rect + origin});
+        }
+    }
+
+    // 在灰度图（整图或窗口）中查找黑色方块，origin 为 gray 左上角在整图中的坐标
+    static void findTargetSquares(const Mat& gray, const Point& origin, const LidarLineDetector::TargetSearchOptions& search, TargetSearchScratch& scratch,
+                                  vector<TargetSquare>& squares)
+    {
+        if (search.finder == LidarLineDetector::TargetFinder::COMPONENTS)
+            findSquaresByComponents(gray, origin, search.minFillRatio, scratch, squares);
+        else
+            findSquaresByContours(gray, origin, scratch, squares);
+    }
+
+    // 显示图像上的说明文字，位置为画布坐标（固定在左上角）
+    struct OverlayText {
+        std::string text;
+        Point org;
+        Scalar color;
+    };
+
+    // 显示图像覆盖的原图区域：方块、中心点、预期位置与容差圆的外接矩形外扩 margin，且不小于说明文字所需的尺寸；
+    // Bayer 图像对齐到偶数坐标以保持排列相位。没有可绘制的几何（未找到任何方块的失败帧）时返回整图
+    static Rect overlayRect(const Mat& image, LidarLineDetector::LaserBayerPattern bayerPattern, const TargetObservation& observation,
+                            const LidarLineDetector::TargetConfig* config, bool succeeded, const vector<OverlayText>& texts, int margin)
+    {
+        const Rect imageRect(0, 0, image.cols, image.rows);
+        Rect bounds;
+        auto include = [&bounds](const Rect& r) { bounds = bounds.empty() ? r : (bounds | r); };
+        for (const TargetSquare& square : observation.squares)
+            include(square.rect);
+        if (observation.located)
+            include(Rect(cvFloor(observation.center.x) - 17, cvFloor(observation.center.y) - 17, 35, 35));
+        if (succeeded) {
+            const int r = cvCeil(config->tolerance) + 2;
+            include(Rect(cvFloor(config->expected_center.x) - r, cvFloor(config->expected_center.y) - r, 2 * r + 1, 2 * r + 1));
+        }
+        if (bounds.empty())
+            return imageRect;
+
+        margin = std::max(margin, 0);
+        Rect canvas(bounds.x - margin, bounds.y - margin, bounds.width + 2 * margin, bounds.height + 2 * margin);
+        for (const OverlayText& t : texts) {
+            int baseline = 0;
+            const Size size = getTextSize(t.text, FONT_HERSHEY_SIMPLEX, 0.7, 2, &baseline);
+            canvas.width = std::max(canvas.width, t.org.x + size.width + 2);
+            canvas.height = std::max(canvas.height, t.org.y + baseline + 2);
+        }
+        canvas.x = std::max(std::min(canvas.x, image.cols - canvas.width), 0);
+        canvas.y = std::max(std::min(canvas.y, image.rows - canvas.height), 0);
+        canvas &= imageRect;
+        if (bayerPattern != LidarLineDetector::LaserBayerPattern::NONE) {
+            const int x0 = canvas.x & ~1, y0 = canvas.y & ~1;
+            const int x1 = std::min((canvas.x + canvas.width + 1) & ~1, image.cols & ~1);
+            const int y1 = std::min((canvas.y + canvas.height + 1) & ~1, image.rows & ~1);
+            canvas = Rect(x0, y0, x1 - x0, y1 - y0);
+        }
+        return canvas.empty() ? imageRect : canvas;
+    }
+
+    // 显示图像：原图转BGR后按检测记录绘制方块与中心点（失败时写出原因）；给出 config 与 result 时再绘制预期位置、
+    // 容差圆与结果文字。只在调用方需要显示图像时执行，颜色转换与绘制都不在检测路径上。
+    // search->cropDisplay 时只转换并绘制标靶附近的区域（画布坐标 = 原图坐标 - 画布左上角，左上角写入 state->displayOrigin）
+    static void renderTargetOverlay(const Mat& image, LidarLineDetector::LaserBayerPattern bayerPattern, int mono16Shift, const TargetObservation& observation,
+                                    const LidarLineDetector::TargetConfig* config, const TargetMovementResult_C* result,
+                                    const LidarLineDetector::TargetSearchOptions* search, LidarLineDetector::TargetSearchState* state, Mat& displayImage)
+    {
+        const bool detailed = config != nullptr && result != nullptr;
+        const bool succeeded = detailed && result->error_code == static_cast<int>(DetectionResultCode::SUCCESS);
+        vector<OverlayText> texts;
+        if (!observation.located) {
+            if (observation.squares.size() != 4)
+                texts.push_back({"Target Detection Failed: " + std::to_string(observation.squares.size()) + " targets found", Point(20, 30), Scalar(0, 0, 255)});
+            else
+                texts.push_back({"Center Calculation Failed", Point(20, 60), Scalar(0, 0, 255)});
+        }
+        if (detailed)
+            texts.push_back(succeeded ? OverlayText{result->message, Point(20, 30), Scalar(0, 255, 0)}
+                                      : OverlayText{"Target Detection Failed", Point(20, 60), Scalar(0, 0, 255)});
+
+        Rect canvasRect(0, 0, image.cols, image.rows);
+        if (search != nullptr && search->cropDisplay)
+            canvasRect = overlayRect(image, bayerPattern, observation, config, succeeded, texts, search->displayMargin);
+        if (state != nullptr)
+            state->displayOrigin = canvasRect.tl();
+        if (!LidarLineDetector::convertToBGR(image(canvasRect), bayerPattern, displayImage, mono16Shift)) {
+            displayImage.release();
+            return;
+        }
+        const Point origin = canvasRect.tl();
+        const Point2f offset(origin);
+        for (const TargetSquare& square : observation.squares) {
+            circle(displayImage, square.center - offset, 8, Scalar(0, 255, 0), 2);
+            rectangle(displayImage, square.rect - origin, Scalar(0, 255, 0), 2);
+        }
+        if (observation.located) {
+            circle(displayImage, observation.center - offset, 10, Scalar(0, 0, 255), -1);
+            circle(displayImage, observation.center - offset, 15, Scalar(0, 0, 255), 2);
+        }
+        if (succeeded) {
+            circle(displayImage, config->expected_center - offset, (int)config->tolerance, Scalar(255, 0, 0), 2);
+            line(displayImage, config->expected_center - offset, observation.center - offset, Scalar(0, 255, 255), 2);
+        }
+        for (const OverlayText& t : texts)
+            putText(displayImage, t.text, t.org, FONT_HERSHEY_SIMPLEX, 0.7, t.color, 2);
+    }
+
+    // 检测标靶四个角落的黑色方块（整图搜索），成功时 squares 按左上、右上、左下、右下排列
+    static bool detectTarget(const Mat& image, vector<TargetSquare>& squares, LidarLineDetector::LaserBayerPattern bayerPattern, int mono16Shift,
+                             const LidarLineDetector::TargetSearchOptions& search, TargetSearchScratch& scratch, spdlog::logger* instanceLogger) {
+        logOf(instanceLogger).info("开始检测标靶四个角落的黑色方块");
+        // 按图像实际格式转灰度（单通道/BGR/BGRA/16位/Bayer）
+        if (!grayInto(image, bayerPattern, mono16Shift, scratch.gray)) {
+            logOf(instanceLogger).error("不支持的图像格式: type={}", image.type());
             return false;
         }
-        
+        squares.clear();
+        findTargetSquares(scratch.gray, Point(0, 0), search, scratch, squares);
+
+        if (squares.size() != 4) {
+            logOf(instanceLogger).warn("未能检测到4个标靶方块，找到: {}", squares.size());
+            return false;
+        }
+
         // 按位置排序：左上、右上、左下、右下
-        sort(centers.begin(), centers.end(), [](const Point2f& a, const Point2f& b) {
-            return a.y < b.y || (a.y == b.y && a.x < b.x);
+        sort(squares.begin(), squares.end(), [](const TargetSquare& a, const TargetSquare& b) {
+            return a.center.y < b.center.y || (a.center.y == b.center.y && a.center.x < b.center.x);
         });
-        if (centers[0].x > centers[1].x) swap(centers[0], centers[1]);
-        if (centers[2].x > centers[3].x) swap(centers[2], centers[3]);
-        
-        corners = centers;
-        logger->info("成功检测到4个标靶方块");
+        if (squares[0].center.x > squares[1].center.x) swap(squares[0], squares[1]);
+        if (squares[2].center.x > squares[3].center.x) swap(squares[2], squares[3]);
+
+        logOf(instanceLogger).info("成功检测到4个标靶方块");
+        return true;
+    }
+
+    // 窗口搜索：第 i 个窗口以 expected_center + cornerOffsets[i] 为中心，边长为方块边长两侧各加 windowMargin，
+    // 只对窗口做灰度换算、形态学与轮廓提取；每个窗口取离预期位置最近的方块，任一窗口未命中返回false
+    static bool detectTargetWindowed(const Mat& image, const LidarLineDetector::TargetConfig& config, LidarLineDetector::LaserBayerPattern bayerPattern, int mono16Shift,
+                                     const LidarLineDetector::TargetSearchOptions& search, const LidarLineDetector::TargetSearchState& state,
+                                     TargetSearchScratch& scratch, vector<TargetSquare>& squares)
+    {
+        const Rect imageRect(0, 0, image.cols, image.rows);
+        const int half = cvCeil(state.squareSize / 2) + std::max(search.windowMargin, 0);
+        squares.clear();
+        vector<TargetSquare>& found = scratch.found;
+        for (int i = 0; i < 4; ++i) {
+            const Point2f expected = config.expected_center + state.cornerOffsets[i];
+            const Rect window = Rect(cvRound(expected.x) - half, cvRound(expected.y) - half, 2 * half + 1, 2 * half + 1) & imageRect;
+            if (window.empty() || !grayInto(image(window), bayerPattern, mono16Shift, scratch.gray))
+                return false;
+            found.clear();
+            findTargetSquares(scratch.gray, window.tl(), search, scratch, found);
+            if (found.empty())
+                return false;
+            const TargetSquare* best = &found[0];
+            for (const TargetSquare& square : found) {
+                Point2f d = square.center - expected, e = best->center - expected;
+                if (d.dot(d) < e.dot(e))
+                    best = &square;
+            }
+            squares.push_back(*best);
+        }
+        return true;
+    }
+
+    // 由整图检测结果学习标靶几何：四个方块相对标靶中心的偏移与平均边长
+    static void learnTargetGeometry(LidarLineDetector::TargetSearchState& state, const vector<TargetSquare>& squares, const Point2f& center)
+    {
+        float size = 0;
+        for (int i = 0; i < 4; ++i) {
+            state.cornerOffsets[i] = squares[i].center - center;
+            size += (squares[i].rect.width + squares[i].rect.height) / 2.0f;
+        }
+        state.squareSize = size / 4;
+        state.geometryValid = true;
+    }
+
+    // 由检测结果（左上、右上、左下、右下）开始跟踪：以每个方块中心、边长两侧各加 trackMargin 取灰度模板
+    // （单通道输入时 convertToGray 返回视图，模板需复制）
+    static void startTracking(const Mat& image, LidarLineDetector::LaserBayerPattern bayerPattern, int mono16Shift, const LidarLineDetector::TargetSearchOptions& search,
+                              LidarLineDetector::TargetSearchState& state, const vector<TargetSquare>& squares)
+    {
+        const Rect imageRect(0, 0, image.cols, image.rows);
+        const int half = cvCeil(state.squareSize / 2) + std::max(search.trackMargin, 1);
+        state.framesSinceDetect = 0;
+        state.trackValid = squares.size() == 4 && state.geometryValid;
+        for (int i = 0; i < 4 && state.trackValid; ++i) {
+            const Point2f& center = squares[i].center;
+            const Rect rect = Rect(cvRound(center.x) - half, cvRound(center.y) - half, 2 * half + 1, 2 * half + 1) & imageRect;
+            state.trackValid = !rect.empty() && grayInto(image(rect), bayerPattern, mono16Shift, state.scratch.gray);
+            if (!state.trackValid)
+                break;
+            state.scratch.gray.copyTo(state.trackPatches[i]);
+            state.trackRects[i] = rect;
+            state.trackOrigins[i] = center;
+        }
+    }
+
+    // 跟踪：每个方块只在模板位置取当前帧灰度块，金字塔LK（窗口覆盖整块方块及其边缘）求模板中心的新位置。
+    // 任一方块丢失（状态位为0、匹配误差超限、位移超出外扩范围）或四个中心的相对位置偏离学到的几何时返回false
+    static bool trackTargetSquares(const Mat& image, LidarLineDetector::LaserBayerPattern bayerPattern, int mono16Shift, const LidarLineDetector::TargetSearchOptions& search,
+                                   const LidarLineDetector::TargetSearchState& state, TargetSearchScratch& scratch, vector<TargetSquare>& squares)
+    {
+        const Rect imageRect(0, 0, image.cols, image.rows);
+        const int margin = std::max(search.trackMargin, 1);
+        const int winHalf = cvCeil(state.squareSize / 2) + 4;
+        const Size winSize(2 * winHalf + 1, 2 * winHalf + 1);
+        const TermCriteria criteria(TermCriteria::COUNT | TermCriteria::EPS, 30, 0.01);
+        vector<Point2f>& prevPts = scratch.prevPts;
+        vector<Point2f>& nextPts = scratch.nextPts;
+        vector<uchar>& status = scratch.status;
+        vector<float>& errors = scratch.errors;
+        prevPts.resize(1);
+        nextPts.resize(1);
+        Point2f centers[4], mean(0, 0);
+        for (int i = 0; i < 4; ++i) {
+            const Rect& rect = state.trackRects[i];
+            const Point2f origin(static_cast<float>(rect.x), static_cast<float>(rect.y));
+            if ((rect & imageRect).area() != rect.area() || !grayInto(image(rect), bayerPattern, mono16Shift, scratch.gray))
+                return false;
+            prevPts[0] = state.trackOrigins[i] - origin;
+            calcOpticalFlowPyrLK(state.trackPatches[i], scratch.gray, prevPts, nextPts, status, errors, winSize, 2, criteria);
+            const Point2f moved = nextPts[0] - prevPts[0];
+            if (!status[0] || errors[0] > search.maxTrackError || std::abs(moved.x) > margin || std::abs(moved.y) > margin)
+                return false;
+            centers[i] = nextPts[0] + origin;
+            mean += centers[i] * 0.25f;
+        }
+        const float maxDeviation = std::max(2.0f, 0.1f * state.squareSize);
+        for (int i = 0; i < 4; ++i) {
+            Point2f d = centers[i] - mean - state.cornerOffsets[i];
+            if (d.dot(d) > maxDeviation * maxDeviation)
+                return false;
+        }
+        const int size = cvRound(state.squareSize);
+        squares.clear();
+        for (int i = 0; i < 4; ++i)
+            squares.push_back({centers[i], Rect(cvRound(centers[i].x - size / 2.0f), cvRound(centers[i].y - size / 2.0f), size, size)});
         return true;
     }
 
     // 计算标靶中心点
-    Point2f calculateTargetCenter(const vector<Point2f>& corners) {
-        if (corners.size() != 4) return Point2f(-1, -1);
-        float centerX = (corners[0].x + corners[1].x + corners[2].x + corners[3].x) / 4.0f;
-        float centerY = (corners[0].y + corners[1].y + corners[2].y + corners[3].y) / 4.0f;
+    static Point2f calculateTargetCenter(const vector<TargetSquare>& squares) {
+        if (squares.size() != 4) return Point2f(-1, -1);
+        float centerX = (squares[0].center.x + squares[1].center.x + squares[2].center.x + squares[3].center.x) / 4.0f;
+        float centerY = (squares[0].center.y + squares[1].center.y + squares[2].center.y + squares[3].center.y) / 4.0f;
         return Point2f(centerX, centerY);
     }
 
-    // 标靶中心点检测
-    DetectionResultCode detectTargetCenter(const Mat &image, Point2f &outCenter, Mat &displayImage)
+    // 标靶中心点：跟踪模式且跟踪有效、未到重新检测周期时先跟踪；窗口模式且已学到几何时在预期位置附近的窗口内搜索，
+    // 都未命中再整图搜索。整图搜索成功后更新学到的几何，检测成功后重新开始跟踪。结果记入 observation，不绘制
+    static DetectionResultCode locateTargetCenter(const Mat &image, const LidarLineDetector::TargetConfig* config, TargetObservation &observation,
+                                                  LidarLineDetector::LaserBayerPattern bayerPattern, int mono16Shift, spdlog::logger *instanceLogger,
+                                                  const LidarLineDetector::TargetSearchOptions* search, LidarLineDetector::TargetSearchState* state)
     {
-        logger->info("开始标靶中心点检测");
-        displayImage = image.clone();
-        
-        vector<Point2f> corners;
-        if (!detectTarget(image, corners, displayImage)) {
+        logOf(instanceLogger).info("开始标靶中心点检测");
+        const LidarLineDetector::TargetSearchOptions options = search != nullptr ? *search : LidarLineDetector::TargetSearchOptions();
+        if (!LidarLineDetector::isSupportedLaserImageType(image.type())) {
+            logOf(instanceLogger).error("不支持的图像格式: type={}", image.type());
+            return DetectionResultCode::IMAGE_LOAD_FAILED;
+        }
+
+        // 有搜索状态时使用其工作缓冲，否则（一次性调用）使用局部缓冲
+        TargetSearchScratch localScratch;
+        TargetSearchScratch& scratch = state != nullptr ? state->scratch : localScratch;
+        vector<TargetSquare>& squares = observation.squares;
+        bool tracked = false, windowed = false;
+        if (options.tracking && state != nullptr && state->trackValid && state->framesSinceDetect < options.redetectEvery) {
+            tracked = trackTargetSquares(image, bayerPattern, mono16Shift, options, *state, scratch, squares);
+            if (tracked) {
+                ++state->trackHits;
+                ++state->framesSinceDetect;
+            } else {
+                ++state->trackLosses;
+                state->trackValid = false;
+                logOf(instanceLogger).info("标靶跟踪丢失，重新检测");
+            }
+        }
+        if (!tracked && config != nullptr && options.windowed && state != nullptr && state->geometryValid) {
+            windowed = detectTargetWindowed(image, *config, bayerPattern, mono16Shift, options, *state, scratch, squares);
+            if (windowed) {
+                ++state->windowHits;
+            } else {
+                ++state->fallbacks;
+                logOf(instanceLogger).info("窗口搜索未命中，回退整图搜索");
+            }
+        }
+        if (!tracked && !windowed && !detectTarget(image, squares, bayerPattern, mono16Shift, options, scratch, instanceLogger)) {
+            if (state != nullptr)
+                state->trackValid = false;
             return DetectionResultCode::CAMERA_SELF_CHECK_FAILED;
         }
-        
-        outCenter = calculateTargetCenter(corners);
-        if (outCenter.x < 0 || outCenter.y < 0) {
-            logger->error("计算标靶中心点失败");
-            cv::putText(displayImage, "Center Calculation Failed", 
-                       cv::Point(20, 60), cv::FONT_HERSHEY_SIMPLEX, 0.7, cv::Scalar(0, 0, 255), 2);
+
+        const Point2f center = calculateTargetCenter(squares);
+        if (center.x < 0 || center.y < 0) {
+            logOf(instanceLogger).error("计算标靶中心点失败");
             return DetectionResultCode::CAMERA_SELF_CHECK_FAILED;
         }
-        
-        // 在显示图像上绘制中心点
-        circle(displayImage, outCenter, 10, Scalar(0, 0, 255), -1);
-        circle(displayImage, outCenter, 15, Scalar(0, 0, 255), 2);
-        
-        logger->info("标靶中心点检测成功: ({:.1f}, {:.1f})", outCenter.x, outCenter.y);
+        observation.center = center;
+        observation.located = true;
+        if (!tracked && !windowed && state != nullptr)
+            learnTargetGeometry(*state, squares, center);
+        if (!tracked && options.tracking && state != nullptr)
+            startTracking(image, bayerPattern, mono16Shift, options, *state, squares);
+
+        logOf(instanceLogger).info("标靶中心点检测成功: ({:.1f}, {:.1f})", center.x, center.y);
+        return DetectionResultCode::SUCCESS;
+    }
+
+    // 标靶中心点检测（调用方传入显示图像即视为需要，检测结束后单独绘制）
+    DetectionResultCode detectTargetCenter(const Mat &image, Point2f &outCenter, Mat &displayImage, LidarLineDetector::LaserBayerPattern bayerPattern, int mono16Shift,
+                                           spdlog::logger *instanceLogger)
+    {
+        vector<TargetSquare> squares;
+        TargetObservation observation(squares);
+        DetectionResultCode err = locateTargetCenter(image, nullptr, observation, bayerPattern, mono16Shift, instanceLogger, nullptr, nullptr);
+        if (err == DetectionResultCode::SUCCESS)
+            outCenter = observation.center;
+        renderTargetOverlay(image, bayerPattern, mono16Shift, observation, nullptr, nullptr, nullptr, nullptr, displayImage);
+        return err;
+    }
+
+    std::string referencePathFor(const std::string& configPath)
+    {
+        size_t pos = configPath.find_last_of("/\\");
+        return (pos == std::string::npos ? std::string() : configPath.substr(0, pos + 1)) + "target_reference.yml";
+    }
+
+    // 降采样灰度（INTER_AREA 兼作抗混叠）→ 去均值 → 加窗 → 补零到最优DFT尺寸 → 复数频谱；window 的尺寸即降采样尺寸。
+    // 中间结果放在 scratch 中（8位与浮点降采样图分开，类型不变才能逐帧复用）
+    static bool computeSpectrum(const Mat& image, LidarLineDetector::LaserBayerPattern bayerPattern, int mono16Shift, int downsample, const Mat& window,
+                                TargetSearchScratch& scratch, Mat& spectrum)
+    {
+        const Mat& gray = scratch.gray;
+        if (!grayInto(image, bayerPattern, mono16Shift, scratch.gray) || gray.cols / downsample != window.cols || gray.rows / downsample != window.rows)
+            return false;
+        Mat& sample = scratch.sampleF;
+        resize(gray, scratch.sample, window.size(), 0, 0, INTER_AREA);
+        scratch.sample.convertTo(sample, CV_32F, 1.0, -mean(scratch.sample)[0]);
+        multiply(sample, window, sample);
+        copyMakeBorder(sample, scratch.padded, 0, getOptimalDFTSize(sample.rows) - sample.rows, 0, getOptimalDFTSize(sample.cols) - sample.cols,
+                       BORDER_CONSTANT, Scalar::all(0));
+        dft(scratch.padded, spectrum, DFT_COMPLEX_OUTPUT);
+        return true;
+    }
+
+    static void buildReferenceWindow(LidarLineDetector::PhaseReference& reference)
+    {
+        createHanningWindow(reference.window, reference.sampleSize, CV_32F);
+    }
+
+    // 相位相关：互功率谱归一化为单位幅值后反变换，峰值位置即平移量（循环坐标），3x3 加权质心给出亚像素位置。
+    // shift 为当前帧相对参考帧的平移（原图像素），response 为峰值（完全一致时为1）；相关峰不为正时返回false
+    static bool estimatePhaseShift(const Mat& image, LidarLineDetector::LaserBayerPattern bayerPattern, int mono16Shift, const LidarLineDetector::PhaseReference& reference,
+                                   TargetSearchScratch& scratch, Point2f& shift, double& response)
+    {
+        Mat& spectrum = scratch.spectrum;
+        if (!computeSpectrum(image, bayerPattern, mono16Shift, reference.downsample, reference.window, scratch, spectrum) || spectrum.size() != reference.spectrum.size())
+            return false;
+        Mat& cross = scratch.cross;
+        mulSpectrums(reference.spectrum, spectrum, cross, 0, true);
+        for (int y = 0; y < cross.rows; ++y) {
+            Vec2f* p = cross.ptr<Vec2f>(y);
+            for (int x = 0; x < cross.cols; ++x) {
+                const float magnitude = std::sqrt(p[x][0] * p[x][0] + p[x][1] * p[x][1]);
+                const float scale = magnitude > 1e-6f ? 1.0f / magnitude : 0.0f;
+                p[x][0] *= scale;
+                p[x][1] *= scale;
+            }
+        }
+        Mat& correlation = scratch.correlation;
+        idft(cross, correlation, DFT_REAL_OUTPUT | DFT_SCALE);
+        Point peak;
+        minMaxLoc(correlation, nullptr, &response, nullptr, &peak);
+
+        const int rows = correlation.rows, cols = correlation.cols;
+        double sum = 0, sx = 0, sy = 0;
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                const float v = correlation.at<float>((peak.y + dy + rows) % rows, (peak.x + dx + cols) % cols);
+                if (v <= 0) continue;
+                sum += v;
+                sx += v * (peak.x + dx);
+                sy += v * (peak.y + dy);
+            }
+        }
+        // 相关面全为零或峰值不为正（空白帧、两帧频谱无重叠）时质心无意义，交由方块检测
+        if (!(sum > 0) || !(response > 0))
+            return false;
+        double cx = sx / sum, cy = sy / sum;
+        if (cx > cols / 2.0) cx -= cols;
+        if (cy > rows / 2.0) cy -= rows;
+        // 当前帧相对参考帧平移 d 时，相关峰位于 -d
+        shift = Point2f(static_cast<float>(-cx * reference.downsample), static_cast<float>(-cy * reference.downsample));
+        return true;
+    }
+
+    DetectionResultCode captureReference(const Mat& image, int downsample, LidarLineDetector::PhaseReference& reference,
+                                         LidarLineDetector::LaserBayerPattern bayerPattern, int mono16Shift, spdlog::logger* instanceLogger)
+    {
+        TargetSearchScratch scratch;
+        TargetObservation observation(scratch.squares);
+        DetectionResultCode err = locateTargetCenter(image, nullptr, observation, bayerPattern, mono16Shift, instanceLogger, nullptr, nullptr);
+        const Point2f center = observation.center;
+        if (err != DetectionResultCode::SUCCESS) {
+            logOf(instanceLogger).error("参考帧标靶检测失败，错误码: {}", static_cast<int>(err));
+            return err;
+        }
+
+        LidarLineDetector::PhaseReference captured;
+        captured.downsample = std::min(std::max(downsample, 1), 16);
+        captured.imageSize = image.size();
+        captured.sampleSize = Size(image.cols / captured.downsample, image.rows / captured.downsample);
+        captured.center = center;
+        if (captured.sampleSize.width < 16 || captured.sampleSize.height < 16) {
+            logOf(instanceLogger).error("降采样后图像过小: {}x{}", captured.sampleSize.width, captured.sampleSize.height);
+            return DetectionResultCode::IMAGE_LOAD_FAILED;
+        }
+        buildReferenceWindow(captured);
+        if (!computeSpectrum(image, bayerPattern, mono16Shift, captured.downsample, captured.window, scratch, captured.spectrum))
+            return DetectionResultCode::IMAGE_LOAD_FAILED;
+        captured.valid = true;
+        reference = captured;
+        logOf(instanceLogger).info("参考频谱采集完成: 标靶中心 ({:.1f}, {:.1f})，降采样 {}，频谱 {}x{}", center.x, center.y, captured.downsample,
+                                   captured.spectrum.cols, captured.spectrum.rows);
+        return DetectionResultCode::SUCCESS;
+    }
+
+    DetectionResultCode saveReference(const string& path, const LidarLineDetector::PhaseReference& reference)
+    {
+        if (!reference.valid)
+            return DetectionResultCode::CONFIG_LOAD_FAILED;
+        FileStorage fs(path, FileStorage::WRITE);
+        if (!fs.isOpened()) {
+            logger->error("无法写入参考频谱: {}", path);
+            return DetectionResultCode::IMAGE_SAVE_FAILED;
+        }
+        fs << "downsample" << reference.downsample;
+        fs << "image_width" << reference.imageSize.width << "image_height" << reference.imageSize.height;
+        fs << "sample_width" << reference.sampleSize.width << "sample_height" << reference.sampleSize.height;
+        fs << "center_x" << reference.center.x << "center_y" << reference.center.y;
+        fs << "spectrum" << reference.spectrum;
+        fs.release();
+        logger->info("参考频谱已保存: {}", path);
+        return DetectionResultCode::SUCCESS;
+    }
+
+    DetectionResultCode loadReference(const string& path, LidarLineDetector::PhaseReference& reference)
+    {
+        FileStorage fs(path, FileStorage::READ);
+        if (!fs.isOpened())
+            return DetectionResultCode::CONFIG_LOAD_FAILED;
+        LidarLineDetector::PhaseReference loaded;
+        loaded.downsample = (int)fs["downsample"];
+        loaded.imageSize = Size((int)fs["image_width"], (int)fs["image_height"]);
+        loaded.sampleSize = Size((int)fs["sample_width"], (int)fs["sample_height"]);
+        loaded.center = Point2f((float)(double)fs["center_x"], (float)(double)fs["center_y"]);
+        read(fs["spectrum"], loaded.spectrum);
+        if (loaded.downsample < 1 || loaded.sampleSize.width < 16 || loaded.sampleSize.height < 16 || loaded.spectrum.type() != CV_32FC2 ||
+            loaded.spectrum.cols != getOptimalDFTSize(loaded.sampleSize.width) || loaded.spectrum.rows != getOptimalDFTSize(loaded.sampleSize.height)) {
+            logger->error("参考频谱文件无效: {}", path);
+            return DetectionResultCode::CONFIG_LOAD_FAILED;
+        }
+        buildReferenceWindow(loaded);
+        loaded.valid = true;
+        reference = loaded;
+        logger->info("已加载参考频谱: {}", path);
         return DetectionResultCode::SUCCESS;
     }
 
     // 相机自检函数
-    TargetMovementResult_C checkCameraMovement(const Mat &image, const LidarLineDetector::TargetConfig &config, Mat &displayImage)
+    TargetMovementResult_C checkCameraMovement(const Mat &image, const LidarLineDetector::TargetConfig &config, Mat &displayImage, LidarLineDetector::LaserBayerPattern bayerPattern, int mono16Shift,
+                                               spdlog::logger *instanceLogger, const LidarLineDetector::TargetSearchOptions *search,
+                                               LidarLineDetector::TargetSearchState *state)
     {
-        logger->info("开始相机移动检测");
+        logOf(instanceLogger).info("开始相机移动检测");
         // 修复：显式转换枚举类型
         TargetMovementResult_C result{0, 0, 0, 0, static_cast<int>(DetectionResultCode::SUCCESS), ""};
-        Point2f currentCenter;
-        DetectionResultCode err = detectTargetCenter(image, currentCenter, displayImage);
+        vector<TargetSquare> localSquares;
+        TargetObservation observation(state != nullptr ? state->scratch.squares : localSquares);
+        bool estimated = false;
+        // 相位相关：估计的中心离预期足够近且相关峰可靠时直接给出结果，不做方块检测（方块被部分遮挡时同样有效）
+        if (search != nullptr && search->phaseShift && state != nullptr && state->reference.valid && image.size() == state->reference.imageSize) {
+            Point2f shift;
+            double response = 0;
+            if (estimatePhaseShift(image, bayerPattern, mono16Shift, state->reference, state->scratch, shift, response)) {
+                Point2f d = state->reference.center + shift - config.expected_center;
+                estimated = response >= search->minResponse && std::sqrt(d.dot(d)) < search->escalateRatio * config.tolerance;
+                logOf(instanceLogger).info("相位相关平移: ({:.2f}, {:.2f})，峰值 {:.3f}{}", shift.x, shift.y, response, estimated ? "" : "，升级为方块检测");
+            }
+            ++(estimated ? state->phaseHits : state->escalations);
+            if (estimated) {
+                observation.center = state->reference.center + shift;
+                observation.located = true;
+            }
+        }
+        DetectionResultCode err = estimated ? DetectionResultCode::SUCCESS
+                                            : locateTargetCenter(image, &config, observation, bayerPattern, mono16Shift, instanceLogger, search, state);
+        const bool render = search == nullptr || search->renderDisplay;
         if (err != DetectionResultCode::SUCCESS)
         {
             result.error_code = static_cast<int>(err);
             snprintf(result.message, sizeof(result.message), "标靶检测失败: %d", result.error_code);
-            logger->error("标靶检测失败，错误码: {}", result.error_code);
-            // 在显示图像上标注失败原因
-            cv::putText(displayImage, "Target Detection Failed", cv::Point(20, 60), cv::FONT_HERSHEY_SIMPLEX, 0.7, cv::Scalar(0, 0, 255), 2);
+            logOf(instanceLogger).error("标靶检测失败，错误码: {}", result.error_code);
+            if (render)
+                renderTargetOverlay(image, bayerPattern, mono16Shift, observation, &config, &result, search, state, displayImage);
+            else
+                displayImage.release();
             return result;
         }
 
+        const Point2f& currentCenter = observation.center;
         float dx = currentCenter.x - config.expected_center.x;
         float dy = currentCenter.y - config.expected_center.y;
         result.dx = dx;
@@ -199,12 +750,13 @@ namespace CameraStabilityDetection {
                  result.is_stable ? "相机稳定，偏差: %.1fpx" : "相机移动！偏差: %.1fpx (>%.1fpx)",
                  result.distance, result.distance, config.tolerance);
 
-        // 在显示图像上绘制检测结果
-        circle(displayImage, config.expected_center, (int)config.tolerance, Scalar(255, 0, 0), 2);
-        line(displayImage, config.expected_center, currentCenter, Scalar(0, 255, 255), 2);
-        putText(displayImage, result.message, Point(20, 30), FONT_HERSHEY_SIMPLEX, 0.7, Scalar(0, 255, 0), 2);
+        // 结果确定后再按需绘制显示图像
+        if (render)
+            renderTargetOverlay(image, bayerPattern, mono16Shift, observation, &config, &result, search, state, displayImage);
+        else
+            displayImage.release();
 
-        logger->info("相机移动检测完成: {} (距离: {:.1f}px)", 
+        logOf(instanceLogger).info("相机移动检测完成: {} (距离: {:.1f}px)", 
                     result.is_stable ? "稳定" : "移动", result.distance);
         return result;
     }
@@ -214,7 +766,47 @@ namespace CameraStabilityDetection {
 // 封装类实现 - 相机自检相关方法
 DetectionResultCode CLidarLineDetector::loadTargetConfig(const char *configPath, LidarLineDetector::TargetConfig &config)
 {
-    return CameraStabilityDetection::loadTargetConfig(configPath, config);
+    DetectionResultCode err = CameraStabilityDetection::loadTargetConfig(configPath, config);
+    if (err == DetectionResultCode::SUCCESS) {
+        m_targetConfigPath = configPath;
+        // 配置旁有缓存的参考频谱时一并加载（没有时保持原参考）
+        CameraStabilityDetection::loadReference(CameraStabilityDetection::referencePathFor(m_targetConfigPath), m_targetState.reference);
+    }
+    return err;
+}
+
+DetectionResultCode CLidarLineDetector::captureStabilityReference(const TCMat_C image, int downsample, const char *referencePath)
+{
+    Mat image_cpp(image.rows, image.cols, image.type, image.data);
+    DetectionResultCode err = CameraStabilityDetection::captureReference(image_cpp, downsample, m_targetState.reference, m_options.bayerPattern, m_options.mono16Shift, m_logger.get());
+    if (err != DetectionResultCode::SUCCESS)
+        return err;
+    std::string path = referencePath != nullptr && referencePath[0] != '\0'
+                           ? std::string(referencePath)
+                           : CameraStabilityDetection::referencePathFor(m_targetConfigPath.empty() ? std::string("config/target_config.txt") : m_targetConfigPath);
+    return CameraStabilityDetection::saveReference(path, m_targetState.reference);
+}
+
+void CLidarLineDetector::setTargetTracking(bool enabled, int redetectEvery, int trackMargin, float maxTrackError)
+{
+    m_targetSearch.tracking = enabled;
+    if (redetectEvery > 0)
+        m_targetSearch.redetectEvery = redetectEvery;
+    if (trackMargin > 0)
+        m_targetSearch.trackMargin = trackMargin;
+    if (maxTrackError > 0)
+        m_targetSearch.maxTrackError = maxTrackError;
+    if (!enabled)
+        m_targetState.trackValid = false;
+}
+
+void CLidarLineDetector::setPhaseShiftCheck(bool enabled, float escalateRatio, float minResponse)
+{
+    m_targetSearch.phaseShift = enabled;
+    if (escalateRatio > 0 && escalateRatio <= 1)
+        m_targetSearch.escalateRatio = escalateRatio;
+    if (minResponse > 0 && minResponse <= 1)
+        m_targetSearch.minResponse = minResponse;
 }
 
 TargetMovementResult_C CLidarLineDetector::checkCameraStability(const TCMat_C image, const TTargetConfig_C config)
@@ -223,8 +815,28 @@ TargetMovementResult_C CLidarLineDetector::checkCameraStability(const TCMat_C im
     LidarLineDetector::TargetConfig internalConfig{
         Point2f(config.center_x, config.center_y),
         config.tolerance};
+    // 显示图像不返回给调用方，不必生成
+    LidarLineDetector::TargetSearchOptions search = m_targetSearch;
+    search.renderDisplay = false;
     Mat displayImage;
-    return CameraStabilityDetection::checkCameraMovement(image_cpp, internalConfig, displayImage);
+    return CameraStabilityDetection::checkCameraMovement(image_cpp, internalConfig, displayImage, m_options.bayerPattern, m_options.mono16Shift, m_logger.get(),
+                                                         &search, &m_targetState);
+}
+
+void CLidarLineDetector::setTargetSearch(bool windowed, int windowMargin)
+{
+    m_targetSearch.windowed = windowed;
+    if (windowMargin > 0)
+        m_targetSearch.windowMargin = windowMargin;
+}
+
+void CLidarLineDetector::setTargetFinder(int finder, float minFillRatio)
+{
+    m_targetSearch.finder = finder == static_cast<int>(LidarLineDetector::TargetFinder::COMPONENTS)
+                                ? LidarLineDetector::TargetFinder::COMPONENTS
+                                : LidarLineDetector::TargetFinder::CONTOURS;
+    if (minFillRatio > 0 && minFillRatio <= 1)
+        m_targetSearch.minFillRatio = minFillRatio;
 }
 
 // C 接口实现 - 相机自检相关
@@ -247,4 +859,29 @@ extern "C"
     {
         return instance->checkCameraStability(image, config);
     }
+
+    Smpclass_API void CLidarLineDetector_setTargetSearch(CLidarLineDetector *instance, int windowed, int windowMargin)
+    {
+        instance->setTargetSearch(windowed != 0, windowMargin);
+    }
+
+    Smpclass_API void CLidarLineDetector_setTargetFinder(CLidarLineDetector *instance, int finder, float minFillRatio)
+    {
+        instance->setTargetFinder(finder, minFillRatio);
+    }
+
+    Smpclass_API DetectionResultCode CLidarLineDetector_captureStabilityReference(CLidarLineDetector *instance, const TCMat_C image, int downsample, const char *referencePath)
+    {
+        return instance->captureStabilityReference(image, downsample, referencePath);
+    }
+
+    Smpclass_API void CLidarLineDetector_setPhaseShiftCheck(CLidarLineDetector *instance, int enabled, float escalateRatio, float minResponse)
+    {
+        instance->setPhaseShiftCheck(enabled != 0, escalateRatio, minResponse);
+    }
+
+    Smpclass_API void CLidarLineDetector_setTargetTracking(CLidarLineDetector *instance, int enabled, int redetectEvery, int trackMargin, float maxTrackError)
+    {
+        instance->setTargetTracking(enabled != 0, redetectEvery, trackMargin, maxTrackError);
+    }
 } 
\ No newline at end of file
@@ -0,0 +1,349 @@
+#include "lidar_line_detection.h"
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include "spdlog/spdlog.h"
+#include "spdlog/sinks/basic_file_sink.h"
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// 飞行记录仪：内存映射环形文件
+namespace LidarLineDetector {
+
+    static std::shared_ptr<spdlog::logger> logger = spdlog::basic_logger_mt("flight_logger", "log/flight_recorder.log");
+
+    // 文件布局：FlightFileHeader，随后 slotCount 个槽，每槽为 FlightSlotHeader 加 slotBytes 字节像素
+    static const char flightMagic[4] = {'L', 'L', 'F', 'R'};
+    static const uint32_t flightVersion = 1;
+
+    struct FlightFileHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t slotCount;
+        uint32_t slotBytes;
+        uint8_t reserved[48];
+    };
+
+    struct FlightSlotHeader {
+        uint64_t sequence; // 0 表示空槽或正在写入，像素与其余字段写完后最后写入
+        int64_t timestampUs;
+        int32_t roiIndex;
+        int32_t roiX, roiY, roiWidth, roiHeight;
+        int32_t bayerPattern;
+        int32_t type;      // 像素类型（cv::Mat::type）
+        int32_t rows;      // 实际保存的行数
+        int32_t cols;
+        int32_t status;
+        float lineAngle;
+        int32_t threshold;
+        int32_t pointCount;
+        int32_t inliers;
+        int32_t scanUs;
+        uint8_t reserved[52];
+    };
+
+    static_assert(sizeof(FlightFileHeader) == 64, "flight file header layout");
+    static_assert(sizeof(FlightSlotHeader) == 128, "flight slot header layout");
+
+    // 槽头与记录之间的互相转换（不含像素）
+    static void toRecord(const FlightSlotHeader& h, FlightRecord& r)
+    {
+        r.sequence = h.sequence;
+        r.timestampUs = h.timestampUs;
+        r.roiIndex = h.roiIndex;
+        r.roiX = h.roiX;
+        r.roiY = h.roiY;
+        r.roiWidth = h.roiWidth;
+        r.roiHeight = h.roiHeight;
+        r.bayerPattern = static_cast<LaserBayerPattern>(h.bayerPattern);
+        r.status = h.status;
+        r.lineAngle = h.lineAngle;
+        r.threshold = h.threshold;
+        r.pointCount = h.pointCount;
+        r.inliers = h.inliers;
+        r.scanUs = h.scanUs;
+    }
+
+    struct FlightRecorder::Impl {
+#ifdef _WIN32
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE mapping = nullptr;
+#else
+        int fd = -1;
+#endif
+        uint8_t* base = nullptr;
+        size_t size = 0;
+        uint32_t slotCount = 0;
+        uint32_t slotBytes = 0;
+        std::atomic<uint64_t> next{0};     // 已分配的记录序号
+        // 每槽一个写锁：序号相差 slotCount 整数倍的两个写端落在同一槽，不加锁时两者交错写入的像素可能通过顺序锁校验
+        std::unique_ptr<std::mutex[]> slotLocks;
+        std::mutex dumpMutex;
+        uint64_t lastDumped = 0;           // 上次转存包含的最大序号
+
+        size_t slotStride() const { return sizeof(FlightSlotHeader) + slotBytes; }
+        uint8_t* slot(uint64_t sequence) const { return base + sizeof(FlightFileHeader) + ((sequence - 1) % slotCount) * slotStride(); }
+        // 映射内存按8字节对齐，序号字段按原子量访问，读写两端据此判断槽内容是否完整
+        static std::atomic<uint64_t>& sequenceOf(uint8_t* slot) { return *reinterpret_cast<std::atomic<uint64_t>*>(slot); }
+
+        bool map(const std::string& path, size_t bytes);
+        void unmap();
+    };
+
+#ifdef _WIN32
+    bool FlightRecorder::Impl::map(const std::string& path, size_t bytes)
+    {
+        file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+        LARGE_INTEGER length;
+        length.QuadPart = static_cast<LONGLONG>(bytes);
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, length.HighPart, length.LowPart, nullptr);
+        if (mapping != nullptr)
+            base = static_cast<uint8_t*>(MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes));
+        if (base == nullptr) {
+            unmap();
+            return false;
+        }
+        size = bytes;
+        return true;
+    }
+
+    void FlightRecorder::Impl::unmap()
+    {
+        if (base != nullptr)
+            UnmapViewOfFile(base);
+        if (mapping != nullptr)
+            CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE)
+            CloseHandle(file);
+        base = nullptr;
+        mapping = nullptr;
+        file = INVALID_HANDLE_VALUE;
+        size = 0;
+    }
+#else
+    bool FlightRecorder::Impl::map(const std::string& path, size_t bytes)
+    {
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0)
+            return false;
+        if (::ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+            unmap();
+            return false;
+        }
+        void* p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) {
+            unmap();
+            return false;
+        }
+        base = static_cast<uint8_t*>(p);
+        size = bytes;
+        return true;
+    }
+
+    void FlightRecorder::Impl::unmap()
+    {
+        if (base != nullptr)
+            ::munmap(base, size);
+        if (fd >= 0)
+            ::close(fd);
+        base = nullptr;
+        fd = -1;
+        size = 0;
+    }
+#endif
+
+    FlightRecorder::FlightRecorder() : m_impl(new Impl) {}
+
+    FlightRecorder::~FlightRecorder()
+    {
+        close();
+    }
+
+    bool FlightRecorder::open(const std::string& path, int slotCount, int slotBytes)
+    {
+        close();
+        if (slotCount <= 0 || slotBytes <= 0)
+            return false;
+        Impl& impl = *m_impl;
+        impl.slotCount = static_cast<uint32_t>(slotCount);
+        impl.slotBytes = static_cast<uint32_t>((slotBytes + 7) & ~7); // 槽头保持8字节对齐
+        impl.slotLocks.reset(new std::mutex[impl.slotCount]);
+        const size_t bytes = sizeof(FlightFileHeader) + impl.slotCount * impl.slotStride();
+        // 新建文件内容为全0，即全部为空槽
+        if (!impl.map(path, bytes)) {
+            logger->error("飞行记录文件映射失败: {} ({} 字节)", path, bytes);
+            return false;
+        }
+        FlightFileHeader header = {};
+        std::memcpy(header.magic, flightMagic, sizeof(flightMagic));
+        header.version = flightVersion;
+        header.slotCount = impl.slotCount;
+        header.slotBytes = impl.slotBytes;
+        std::memcpy(impl.base, &header, sizeof(header));
+        impl.next.store(0);
+        impl.lastDumped = 0;
+        logger->info("飞行记录文件已映射: {}，{} 槽 x {} 字节", path, impl.slotCount, impl.slotBytes);
+        return true;
+    }
+
+    void FlightRecorder::close()
+    {
+        m_impl->unmap();
+    }
+
+    bool FlightRecorder::isOpen() const
+    {
+        return m_impl->base != nullptr;
+    }
+
+    void FlightRecorder::record(const cv::Mat& roiView, const FlightRecord& meta)
+    {
+        Impl& impl = *m_impl;
+        if (impl.base == nullptr || roiView.empty())
+            return;
+        const uint64_t sequence = impl.next.fetch_add(1) + 1;
+        uint8_t* slot = impl.slot(sequence);
+        // 同一槽的写端串行执行；槽中已是更新的记录时丢弃本条（环形文件只保留每槽最新的一条）
+        std::lock_guard<std::mutex> slotLock(impl.slotLocks[(sequence - 1) % impl.slotCount]);
+        std::atomic<uint64_t>& slotSequence = Impl::sequenceOf(slot);
+        if (slotSequence.load(std::memory_order_relaxed) > sequence)
+            return;
+        // 顺序锁写端：先把序号置0（写入中），release 栅栏保证这一标记先于下面任何像素/槽头写入对其他线程、
+        // 其他进程（同一映射）可见；内容写完后以 release 写入新序号
+        slotSequence.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        const size_t rowBytes = roiView.cols * roiView.elemSize();
+        const int rows = static_cast<int>(std::min<size_t>(roiView.rows, rowBytes > 0 ? impl.slotBytes / rowBytes : 0));
+        uint8_t* pixels = slot + sizeof(FlightSlotHeader);
+        for (int y = 0; y < rows; ++y)
+            std::memcpy(pixels + y * rowBytes, roiView.ptr(y), rowBytes);
+
+        FlightSlotHeader h = {};
+        h.timestampUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        h.roiIndex = meta.roiIndex;
+        h.roiX = meta.roiX;
+        h.roiY = meta.roiY;
+        h.roiWidth = meta.roiWidth;
+        h.roiHeight = meta.roiHeight;
+        h.bayerPattern = static_cast<int32_t>(meta.bayerPattern);
+        h.type = roiView.type();
+        h.rows = rows;
+        h.cols = roiView.cols;
+        h.status = meta.status;
+        h.lineAngle = meta.lineAngle;
+        h.threshold = meta.threshold;
+        h.pointCount = meta.pointCount;
+        h.inliers = meta.inliers;
+        h.scanUs = meta.scanUs;
+        std::memcpy(slot + sizeof(uint64_t), reinterpret_cast<const uint8_t*>(&h) + sizeof(uint64_t), sizeof(h) - sizeof(uint64_t));
+        slotSequence.store(sequence, std::memory_order_release);
+    }
+
+    int FlightRecorder::dump(const std::string& dumpPath, int window, int minNewRecords)
+    {
+        Impl& impl = *m_impl;
+        if (impl.base == nullptr || window <= 0)
+            return 0;
+        std::lock_guard<std::mutex> lock(impl.dumpMutex);
+        const uint64_t newest = impl.next.load();
+        if (newest == 0 || newest == impl.lastDumped ||
+            (impl.lastDumped > 0 && newest < impl.lastDumped + static_cast<uint64_t>(std::max(minNewRecords, 0))))
+            return 0;
+        const uint64_t count = std::min<uint64_t>({static_cast<uint64_t>(window), newest, impl.slotCount});
+
+        // 顺序锁读端：acquire 读序号 → 整槽 memcpy 到本地副本 → acquire 栅栏 → 再读序号，
+        // 两次都等于期望序号才采用副本（期间被覆盖或尚未写完的槽跳过）
+        const size_t stride = impl.slotStride();
+        std::vector<uint8_t> slots;
+        slots.reserve(count * stride);
+        std::vector<uint8_t> local(stride);
+        uint32_t written = 0;
+        for (uint64_t sequence = newest - count + 1; sequence <= newest; ++sequence) {
+            uint8_t* slot = impl.slot(sequence);
+            std::atomic<uint64_t>& slotSequence = Impl::sequenceOf(slot);
+            if (slotSequence.load(std::memory_order_acquire) != sequence)
+                continue;
+            std::memcpy(local.data(), slot, stride);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slotSequence.load(std::memory_order_acquire) != sequence)
+                continue;
+            std::memcpy(local.data(), &sequence, sizeof(sequence)); // 副本中的序号字段不是原子读取，以校验过的值为准
+            slots.insert(slots.end(), local.begin(), local.end());
+            ++written;
+        }
+
+        FlightFileHeader header = {};
+        std::memcpy(header.magic, flightMagic, sizeof(flightMagic));
+        header.version = flightVersion;
+        header.slotCount = written;
+        header.slotBytes = impl.slotBytes;
+        std::ofstream out(dumpPath, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(slots.data()), static_cast<std::streamsize>(slots.size()));
+        if (!out) {
+            logger->error("飞行记录转存失败: {}", dumpPath);
+            return 0;
+        }
+        impl.lastDumped = newest;
+        logger->info("飞行记录已转存: {}，{} 条（序号至 {}）", dumpPath, written, newest);
+        return static_cast<int>(written);
+    }
+
+    uint64_t FlightRecorder::recorded() const
+    {
+        return m_impl->next.load();
+    }
+
+    bool readFlightRecords(const std::string& path, std::vector<FlightRecord>& records)
+    {
+        records.clear();
+        std::ifstream in(path, std::ios::binary);
+        FlightFileHeader header;
+        if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+            std::memcmp(header.magic, flightMagic, sizeof(flightMagic)) != 0 || header.version != flightVersion)
+        {
+            logger->error("不是有效的飞行记录文件: {}", path);
+            return false;
+        }
+        // 环形文件可能正被另一进程写入：槽头与像素读入本地后重读序号，与槽头中的序号一致才采用
+        // （写端先把序号置0再写内容，写完才写入新序号；转存文件内容固定，重读结果总是一致）
+        std::vector<uint8_t> pixels(header.slotBytes);
+        for (uint32_t i = 0; i < header.slotCount; ++i) {
+            const std::streamoff slotOffset = in.tellg();
+            FlightSlotHeader h;
+            uint64_t recheck = 0;
+            if (!in.read(reinterpret_cast<char*>(&h), sizeof(h)) ||
+                !in.read(reinterpret_cast<char*>(pixels.data()), header.slotBytes))
+                break; // 文件被截断：保留已读到的记录
+            const std::streamoff nextOffset = in.tellg();
+            if (!in.seekg(slotOffset) || !in.read(reinterpret_cast<char*>(&recheck), sizeof(recheck)) || !in.seekg(nextOffset))
+                break;
+            if (recheck != h.sequence)
+                continue;
+            if (h.sequence == 0 || h.rows <= 0 || h.cols <= 0 ||
+                static_cast<size_t>(h.rows) * h.cols * CV_ELEM_SIZE(h.type) > header.slotBytes)
+                continue;
+            FlightRecord r;
+            toRecord(h, r);
+            r.image = cv::Mat(h.rows, h.cols, h.type, pixels.data()).clone();
+            records.push_back(r);
+        }
+        std::sort(records.begin(), records.end(), [](const FlightRecord& a, const FlightRecord& b) { return a.sequence < b.sequence; });
+        return true;
+    }
+
+} // namespace LidarLineDetector
@@ -0,0 +1,67 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <opencv2/opencv.hpp>
+#include "lidar_line_detection.h"
+#ifdef _WIN32
+#include <windows.h>
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+// 飞行记录转存文件还原工具：每条记录输出一张PNG（16位图像保持原始位深，Bayer图像解马赛克），
+// 检测结果与耗时写入 records.csv
+// 用法: FlightRecorderTool <转存文件或环形文件> <输出目录>
+int main(int argc, char** argv) {
+#ifdef _WIN32
+    SetConsoleOutputCP(CP_UTF8);
+#endif
+    if (argc < 3) {
+        std::cout << "用法: " << argv[0] << " <飞行记录文件> <输出目录>" << std::endl;
+        return 1;
+    }
+    const std::string dumpPath = argv[1];
+    const std::string outputDir = argv[2];
+#ifdef _WIN32
+    _mkdir(outputDir.c_str());
+#else
+    mkdir(outputDir.c_str(), 0755);
+#endif
+
+    std::vector<LidarLineDetector::FlightRecord> records;
+    if (!LidarLineDetector::readFlightRecords(dumpPath, records)) {
+        std::cout << "[错误] 无法读取飞行记录: " << dumpPath << std::endl;
+        return 1;
+    }
+
+    std::ofstream csv(outputDir + "/records.csv");
+    csv << "sequence,timestamp_us,roi_index,roi_x,roi_y,roi_width,roi_height,status,line_angle_deg,threshold,point_count,inliers,scan_us,image\n";
+    int saved = 0;
+    for (const LidarLineDetector::FlightRecord& r : records) {
+        std::ostringstream name;
+        name << std::setw(10) << std::setfill('0') << r.sequence << "_roi" << r.roiIndex << ".png";
+        const std::string fileName = outputDir + "/" + name.str();
+
+        cv::Mat output;
+        if (r.image.depth() == CV_16U && r.image.channels() == 1)
+            output = r.image; // PNG 支持16位，保留原始数据
+        else if (!LidarLineDetector::convertToBGR(r.image, r.bayerPattern, output))
+            output.release();
+        bool ok = !output.empty() && cv::imwrite(fileName, output);
+        if (ok)
+            ++saved;
+        else
+            std::cout << "[警告] 记录 " << r.sequence << " 无法还原为图像（type=" << r.image.type() << "）" << std::endl;
+
+        csv << r.sequence << ',' << r.timestampUs << ',' << r.roiIndex << ','
+            << r.roiX << ',' << r.roiY << ',' << r.roiWidth << ',' << r.roiHeight << ','
+            << r.status << ',' << std::fixed << std::setprecision(3) << r.lineAngle * 180.0 / CV_PI << ','
+            << r.threshold << ',' << r.pointCount << ',' << r.inliers << ',' << r.scanUs << ','
+            << (ok ? name.str() : "") << '\n';
+    }
+    std::cout << "共 " << records.size() << " 条记录，已还原 " << saved << " 张图像到 " << outputDir << std::endl;
+    return 0;
+}
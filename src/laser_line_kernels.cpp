@@ -0,0 +1,1147 @@
+#include "lidar_line_detection.h"
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include <limits>
+#include <cstdint>
+#include <chrono>
+#include <random>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define LASER_KERNEL_SSE2 1
+    #include <emmintrin.h>
+#endif
+
+// AVX2 不要求编译选项开启，按函数单独编译并在运行时检测CPU支持
+#if LASER_KERNEL_SSE2 && (defined(__GNUC__) || defined(__clang__))
+    #define LASER_KERNEL_AVX2 1
+    #define LASER_TARGET_AVX2 __attribute__((target("avx2")))
+    #include <immintrin.h>
+#elif LASER_KERNEL_SSE2 && defined(_MSC_VER)
+    #define LASER_KERNEL_AVX2 1
+    #define LASER_TARGET_AVX2
+    #include <immintrin.h>
+    #include <intrin.h>
+#endif
+
+// 激光线检测底层计算内核
+namespace LidarLineDetector {
+
+    void LaserPointSet::reserve(size_t n)
+    {
+        count = 0;
+        if (n <= capacity)
+            return;
+        xs.reset(new int[n]);
+        ys.reset(new int[n]);
+        capacity = n;
+    }
+
+    // 取最低位1的下标
+    static inline int lowestBit(unsigned int mask)
+    {
+#if defined(_MSC_VER) && !defined(__clang__)
+        unsigned long idx;
+        _BitScanForward(&idx, mask);
+        return static_cast<int>(idx);
+#else
+        return __builtin_ctz(mask);
+#endif
+    }
+
+    // 标量版本：逐像素比较，同时用于SIMD尾部处理
+    static int compactRowScalar(const uchar* row, int begin, int width, uchar threshold, int* xs)
+    {
+        int n = 0;
+        for (int x = begin; x < width; ++x) {
+            xs[n] = x;
+            n += row[x] > threshold;
+        }
+        return n;
+    }
+
+#if LASER_KERNEL_SSE2
+    // 无符号比较：两边同时异或0x80后做有符号比较
+    static int compactRowSSE2(const uchar* row, int begin, int width, uchar threshold, int* xs)
+    {
+        const __m128i bias = _mm_set1_epi8(static_cast<char>(0x80));
+        const __m128i thr = _mm_set1_epi8(static_cast<char>(threshold ^ 0x80));
+        int n = 0;
+        int x = begin;
+        for (; x + 16 <= width; x += 16) {
+            __m128i v = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x)), bias);
+            unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpgt_epi8(v, thr)));
+            while (mask) {
+                xs[n++] = x + lowestBit(mask);
+                mask &= mask - 1;
+            }
+        }
+        return n + compactRowScalar(row, x, width, threshold, xs + n);
+    }
+#endif
+
+#if LASER_KERNEL_AVX2
+    LASER_TARGET_AVX2 static int compactRowAVX2(const uchar* row, int begin, int width, uchar threshold, int* xs)
+    {
+        const __m256i bias = _mm256_set1_epi8(static_cast<char>(0x80));
+        const __m256i thr = _mm256_set1_epi8(static_cast<char>(threshold ^ 0x80));
+        int n = 0;
+        int x = begin;
+        for (; x + 32 <= width; x += 32) {
+            __m256i v = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x)), bias);
+            unsigned int mask = static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_cmpgt_epi8(v, thr)));
+            while (mask) {
+                xs[n++] = x + lowestBit(mask);
+                mask &= mask - 1;
+            }
+        }
+        return n + compactRowSSE2(row, x, width, threshold, xs + n);
+    }
+
+    static bool cpuHasAVX2()
+    {
+#if defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return false;
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        if (!osxsave || (_xgetbv(0) & 0x6) != 0x6)
+            return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+#endif
+
+    typedef int (*CompactRowFunc)(const uchar*, int, int, uchar, int*);
+
+    // 运行时选择最快的行内核（只检测一次）
+    static CompactRowFunc selectCompactRow()
+    {
+#if LASER_KERNEL_AVX2
+        if (cpuHasAVX2())
+            return compactRowAVX2;
+#endif
+#if LASER_KERNEL_SSE2
+        return compactRowSSE2;
+#else
+        return compactRowScalar;
+#endif
+    }
+
+    bool isSupportedLaserImageType(int type)
+    {
+        return type == CV_8UC1 || type == CV_8UC3 || type == CV_8UC4 || type == CV_16UC1;
+    }
+
+    LaserPixelFormat resolveLaserPixelFormat(int type, LaserBayerPattern bayerPattern)
+    {
+        switch (type) {
+        case CV_8UC1:
+            return bayerPattern == LaserBayerPattern::NONE ? LaserPixelFormat::MONO8 : LaserPixelFormat::BAYER8;
+        case CV_8UC3:
+            return LaserPixelFormat::BGR8;
+        case CV_8UC4:
+            return LaserPixelFormat::BGRA8;
+        case CV_16UC1:
+            return LaserPixelFormat::MONO16;
+        default:
+            return LaserPixelFormat::UNSUPPORTED;
+        }
+    }
+
+    // 亮度系数与 cvtColor(COLOR_BGR2GRAY) 的14位定点实现一致
+    static inline uchar luminance(int b, int g, int r)
+    {
+        return static_cast<uchar>((b * 1868 + g * 9617 + r * 4899 + (1 << 13)) >> 14);
+    }
+
+    // 将一行彩色像素就地换算为强度
+    static void rowToIntensity(const uchar* src, int width, int cn, IntensityChannel channel, uchar* dst)
+    {
+        if (channel == IntensityChannel::LUMINANCE) {
+            for (int x = 0; x < width; ++x, src += cn) {
+                dst[x] = luminance(src[0], src[1], src[2]);
+            }
+            return;
+        }
+        int c = static_cast<int>(channel) - 1; // BGR顺序
+        for (int x = 0; x < width; ++x) {
+            dst[x] = src[x * cn + c];
+        }
+    }
+
+    // 各像素格式的强度读取：row(y, buf) 返回第y行的8位强度（可直接返回图像行指针，否则换算到buf，
+    // 单行缓冲常驻L1），at(x, y) 返回单个像素强度。提取与拟合内核按格式模板实例化，格式在每次调用入口处分派一次
+
+    // 8位单通道：直接返回行指针，不复制
+    class Mono8Pixels {
+    public:
+        Mono8Pixels(const cv::Mat& view, const LaserDetectionOptions&) : m_view(view) {}
+        int rows() const { return m_view.rows; }
+        int cols() const { return m_view.cols; }
+        const uchar* row(int y, uchar*) const { return m_view.ptr<uchar>(y); }
+        int at(int x, int y) const { return m_view.ptr<uchar>(y)[x]; }
+
+    private:
+        const cv::Mat& m_view;
+    };
+
+    // 8位BGR/BGRA：通道数为编译期常量
+    template <int CN>
+    class Color8Pixels {
+    public:
+        Color8Pixels(const cv::Mat& view, const LaserDetectionOptions& options) : m_view(view), m_channel(options.channel) {}
+        int rows() const { return m_view.rows; }
+        int cols() const { return m_view.cols; }
+        const uchar* row(int y, uchar* buf) const
+        {
+            rowToIntensity(m_view.ptr<uchar>(y), m_view.cols, CN, m_channel, buf);
+            return buf;
+        }
+        int at(int x, int y) const
+        {
+            uchar v;
+            rowToIntensity(m_view.ptr<uchar>(y) + x * CN, 1, CN, m_channel, &v);
+            return v;
+        }
+
+    private:
+        const cv::Mat& m_view;
+        IntensityChannel m_channel;
+    };
+
+    // 16位单通道：右移 mono16Shift 位后饱和到8位
+    class Mono16Pixels {
+    public:
+        Mono16Pixels(const cv::Mat& view, const LaserDetectionOptions& options)
+            : m_view(view), m_shift(std::min(std::max(options.mono16Shift, 0), 15)) {}
+        int rows() const { return m_view.rows; }
+        int cols() const { return m_view.cols; }
+        const uchar* row(int y, uchar* buf) const
+        {
+            const uint16_t* src = m_view.ptr<uint16_t>(y);
+            for (int x = 0; x < m_view.cols; ++x)
+                buf[x] = static_cast<uchar>(std::min(src[x] >> m_shift, 255));
+            return buf;
+        }
+        int at(int x, int y) const { return std::min(m_view.ptr<uint16_t>(y)[x] >> m_shift, 255); }
+
+    private:
+        const cv::Mat& m_view;
+        int m_shift;
+    };
+
+    // 原始Bayer（8位）：每个像素取所在2x2单元的 R、(G1+G2)/2、B 换算强度，不做插值去马赛克。
+    // 单元按整幅图像对齐，ROI视图的奇偶偏移由 locateROI 求得；边缘不完整的单元借用相邻同色行/列
+    class Bayer8Pixels {
+    public:
+        Bayer8Pixels(const cv::Mat& view, const LaserDetectionOptions& options) : m_view(view), m_channel(options.channel)
+        {
+            cv::Size whole;
+            cv::Point ofs;
+            view.locateROI(whole, ofs);
+            m_phaseX = ofs.x & 1;
+            m_phaseY = ofs.y & 1;
+            // 左上角2x2单元中R、B的位置（0:(0,0) 1:(0,1) 2:(1,0) 3:(1,1)）
+            switch (options.bayerPattern) {
+            case LaserBayerPattern::BGGR: m_r = 3; m_b = 0; break;
+            case LaserBayerPattern::GRBG: m_r = 1; m_b = 2; break;
+            case LaserBayerPattern::GBRG: m_r = 2; m_b = 1; break;
+            default:                      m_r = 0; m_b = 3; break;
+            }
+        }
+        int rows() const { return m_view.rows; }
+        int cols() const { return m_view.cols; }
+        const uchar* row(int y, uchar* buf) const
+        {
+            const uchar* r0;
+            const uchar* r1;
+            cellRows(y, r0, r1);
+            for (int x = 0; x < m_view.cols; ++x)
+                buf[x] = cell(r0, r1, x);
+            return buf;
+        }
+        int at(int x, int y) const
+        {
+            const uchar* r0;
+            const uchar* r1;
+            cellRows(y, r0, r1);
+            return cell(r0, r1, x);
+        }
+
+    private:
+        // 同一单元内另一行/列的下标，越界时取另一侧（同色）
+        static int partner(int i, int phase, int size)
+        {
+            int p = phase == 0 ? i + 1 : i - 1;
+            if (p < 0 || p >= size)
+                p = phase == 0 ? i - 1 : i + 1;
+            return (p < 0 || p >= size) ? i : p;
+        }
+        void cellRows(int y, const uchar*& r0, const uchar*& r1) const
+        {
+            int phase = (y + m_phaseY) & 1;
+            int yp = partner(y, phase, m_view.rows);
+            r0 = m_view.ptr<uchar>(phase == 0 ? y : yp);
+            r1 = m_view.ptr<uchar>(phase == 0 ? yp : y);
+        }
+        uchar cell(const uchar* r0, const uchar* r1, int x) const
+        {
+            int phase = (x + m_phaseX) & 1;
+            int xp = partner(x, phase, m_view.cols);
+            int c0 = phase == 0 ? x : xp, c1 = phase == 0 ? xp : x;
+            int v[4] = {r0[c0], r0[c1], r1[c0], r1[c1]};
+            int r = v[m_r], b = v[m_b];
+            int g = (v[0] + v[1] + v[2] + v[3] - r - b + 1) >> 1;
+            switch (m_channel) {
+            case IntensityChannel::RED: return static_cast<uchar>(r);
+            case IntensityChannel::GREEN: return static_cast<uchar>(g);
+            case IntensityChannel::BLUE: return static_cast<uchar>(b);
+            default: return luminance(b, g, r);
+            }
+        }
+
+        const cv::Mat& m_view;
+        IntensityChannel m_channel;
+        int m_phaseX = 0, m_phaseY = 0;
+        int m_r = 0, m_b = 3;
+    };
+
+    // 按视图的像素格式构造对应的读取器并调用 func；调用方需先确认格式受支持
+    template <class Func>
+    static auto withPixels(const cv::Mat& view, const LaserDetectionOptions& options, Func&& func)
+        -> decltype(func(std::declval<const Mono8Pixels&>()))
+    {
+        switch (resolveLaserPixelFormat(view.type(), options.bayerPattern)) {
+        case LaserPixelFormat::BGR8:
+            return func(Color8Pixels<3>(view, options));
+        case LaserPixelFormat::BGRA8:
+            return func(Color8Pixels<4>(view, options));
+        case LaserPixelFormat::MONO16:
+            return func(Mono16Pixels(view, options));
+        case LaserPixelFormat::BAYER8:
+            return func(Bayer8Pixels(view, options));
+        default:
+            return func(Mono8Pixels(view, options));
+        }
+    }
+
+    void computeLaserIntensity(const cv::Mat& view, const LaserDetectionOptions& options, cv::Mat& intensity)
+    {
+        if (resolveLaserPixelFormat(view.type(), options.bayerPattern) == LaserPixelFormat::MONO8) {
+            intensity = view;
+            return;
+        }
+        intensity.create(view.rows, view.cols, CV_8UC1);
+        withPixels(view, options, [&](const auto& px) {
+            for (int y = 0; y < px.rows(); ++y) {
+                uchar* dst = intensity.ptr<uchar>(y);
+                const uchar* row = px.row(y, dst);
+                if (row != dst)
+                    std::copy(row, row + px.cols(), dst);
+            }
+        });
+    }
+
+    // OpenCV 的 Bayer 转换码以第二行第二、三列命名，与按左上角命名的排列对应如下
+    static int bayerConversionCode(LaserBayerPattern pattern, bool toGray)
+    {
+        switch (pattern) {
+        case LaserBayerPattern::BGGR: return toGray ? cv::COLOR_BayerRG2GRAY : cv::COLOR_BayerRG2BGR;
+        case LaserBayerPattern::GRBG: return toGray ? cv::COLOR_BayerGB2GRAY : cv::COLOR_BayerGB2BGR;
+        case LaserBayerPattern::GBRG: return toGray ? cv::COLOR_BayerGR2GRAY : cv::COLOR_BayerGR2BGR;
+        default:                      return toGray ? cv::COLOR_BayerBG2GRAY : cv::COLOR_BayerBG2BGR;
+        }
+    }
+
+    // 子图左上角落在奇数行/列时，子图自身的排列相应翻转
+    LaserBayerPattern bayerPatternAt(LaserBayerPattern pattern, int x, int y)
+    {
+        static const LaserBayerPattern flipX[] = {LaserBayerPattern::NONE, LaserBayerPattern::GRBG, LaserBayerPattern::GBRG, LaserBayerPattern::RGGB, LaserBayerPattern::BGGR};
+        static const LaserBayerPattern flipY[] = {LaserBayerPattern::NONE, LaserBayerPattern::GBRG, LaserBayerPattern::GRBG, LaserBayerPattern::BGGR, LaserBayerPattern::RGGB};
+        if (x & 1)
+            pattern = flipX[static_cast<int>(pattern)];
+        if (y & 1)
+            pattern = flipY[static_cast<int>(pattern)];
+        return pattern;
+    }
+
+    static LaserBayerPattern bayerPatternOfView(const cv::Mat& view, LaserBayerPattern pattern)
+    {
+        cv::Size whole;
+        cv::Point ofs;
+        view.locateROI(whole, ofs);
+        return bayerPatternAt(pattern, ofs.x, ofs.y);
+    }
+
+    bool convertToGray(const cv::Mat& image, LaserBayerPattern bayerPattern, cv::Mat& gray, int mono16Shift)
+    {
+        switch (resolveLaserPixelFormat(image.type(), bayerPattern)) {
+        case LaserPixelFormat::MONO8:
+            gray = image;
+            return true;
+        case LaserPixelFormat::BGR8:
+            cv::cvtColor(image, gray, cv::COLOR_BGR2GRAY);
+            return true;
+        case LaserPixelFormat::BGRA8:
+            cv::cvtColor(image, gray, cv::COLOR_BGRA2GRAY);
+            return true;
+        case LaserPixelFormat::MONO16: {
+            // 与 Mono16Pixels 相同：右移后饱和到8位，显示亮度与检测比较的强度一致
+            const int shift = std::min(std::max(mono16Shift, 0), 15);
+            gray.create(image.size(), CV_8UC1);
+            for (int y = 0; y < image.rows; ++y) {
+                const uint16_t* src = image.ptr<uint16_t>(y);
+                uchar* dst = gray.ptr<uchar>(y);
+                for (int x = 0; x < image.cols; ++x)
+                    dst[x] = static_cast<uchar>(std::min(src[x] >> shift, 255));
+            }
+            return true;
+        }
+        case LaserPixelFormat::BAYER8:
+            cv::cvtColor(image, gray, bayerConversionCode(bayerPatternOfView(image, bayerPattern), true));
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    bool convertToBGR(const cv::Mat& image, LaserBayerPattern bayerPattern, cv::Mat& bgr, int mono16Shift)
+    {
+        switch (resolveLaserPixelFormat(image.type(), bayerPattern)) {
+        case LaserPixelFormat::BGR8:
+            image.copyTo(bgr);
+            return true;
+        case LaserPixelFormat::BGRA8:
+            cv::cvtColor(image, bgr, cv::COLOR_BGRA2BGR);
+            return true;
+        case LaserPixelFormat::BAYER8:
+            cv::cvtColor(image, bgr, bayerConversionCode(bayerPatternOfView(image, bayerPattern), false));
+            return true;
+        default: {
+            cv::Mat gray;
+            if (!convertToGray(image, bayerPattern, gray, mono16Shift))
+                return false;
+            cv::cvtColor(gray, bgr, cv::COLOR_GRAY2BGR);
+            return true;
+        }
+        }
+    }
+
+    size_t extractLaserPoints(const cv::Mat& roiView, const LaserDetectionOptions& options, uchar threshold, LaserPointSet& points)
+    {
+        static const CompactRowFunc compactRow = selectCompactRow();
+
+        points.reserve(roiView.total());
+        if (!isSupportedLaserImageType(roiView.type()))
+            return 0;
+
+        std::vector<uchar> rowBuf(roiView.cols);
+        size_t n = 0;
+        withPixels(roiView, options, [&](const auto& px) {
+            for (int y = 0; y < px.rows(); ++y) {
+                const uchar* row = px.row(y, rowBuf.data());
+                int hits = compactRow(row, 0, px.cols(), threshold, points.xs.get() + n);
+                std::fill_n(points.ys.get() + n, hits, y);
+                n += hits;
+            }
+        });
+        points.count = n;
+        return n;
+    }
+
+    // 自适应模式每行候选点容量：激光每行只占少数像素，按列数的1/8封顶；x 以16位存储，过宽的ROI不缓存候选点
+    static int adaptiveCandidateStride(int cols)
+    {
+        return cols > 65535 ? 0 : std::min(cols, std::max(cols / 8, 64));
+    }
+
+    void LaserLineAccumulator::reserve(int rows, int cols, const LaserDetectionOptions& options)
+    {
+        rows = std::max(rows, 0);
+        cols = std::max(cols, 0);
+        rowMinX.reserve(rows);
+        rowMaxX.reserve(rows);
+        colWeight.reserve(cols);
+        colWeightY.reserve(cols);
+        colPeak.reserve(cols);
+        colPeakY.reserve(cols);
+        colCenterY.reserve(cols);
+        histogram.reserve(256);
+        subHist.reserve(4 * 256);
+        rowBuf.reserve(cols);
+        rowXs.reserve(cols);
+        if (options.fitMode == LaserFitMode::RANSAC)
+            sample.reserve(static_cast<size_t>(std::max(options.ransacMaxSamples, 2)));
+        if (options.thresholdMode != LaserThresholdMode::FIXED) {
+            candX.reserve(static_cast<size_t>(rows) * adaptiveCandidateStride(cols));
+            candV.reserve(static_cast<size_t>(rows) * adaptiveCandidateStride(cols));
+            candRowCount.reserve(rows);
+        }
+        if (options.workerPool == nullptr)
+            return;
+        // 行带部分累加器：自适应模式的候选点写入本累加器，行带只需自身的行缓冲与统计量
+        LaserDetectionOptions bandOptions = options;
+        bandOptions.workerPool = nullptr;
+        bandOptions.thresholdMode = LaserThresholdMode::FIXED;
+        const int bandRows = std::max(options.bandRows, 1);
+        const size_t bandCount = static_cast<size_t>((rows + bandRows - 1) / bandRows);
+        if (bands.size() < bandCount)
+            bands.resize(bandCount);
+        bandTotals.reserve(bandCount);
+        for (LaserLineAccumulator& band : bands)
+            band.reserve(rows, cols, bandOptions);
+    }
+
+    void LaserScratchArena::reserve(const std::vector<ROI>& rois, const LaserDetectionOptions& options)
+    {
+        if (accumulators.size() < std::max<size_t>(rois.size(), 1))
+            accumulators.resize(std::max<size_t>(rois.size(), 1));
+        for (size_t i = 0; i < rois.size(); ++i)
+            accumulators[i].reserve(rois[i].height, rois[i].width, options);
+    }
+
+    void LaserLineAccumulator::reset(int rows, int cols, LaserExtractionMode mode, size_t capacity)
+    {
+        n = sx = sy = sxx = sxy = syy = 0;
+        sample.clear();
+        sample.reserve(capacity);
+        sampleCapacity = capacity;
+        sampleStride = 1;
+        if (mode == LaserExtractionMode::THRESHOLD) {
+            rowMinX.assign(rows, -1);
+            rowMaxX.assign(rows, -1);
+            // 列统计量在阈值模式下不使用：清空（保留容量），归并时按列循环为空，不会读到上一种模式或其他宽度留下的数据
+            colWeight.clear();
+            colWeightY.clear();
+            colPeak.clear();
+            colPeakY.clear();
+            colCenterY.clear();
+        } else {
+            rowMinX.clear();
+            rowMaxX.clear();
+            colWeight.assign(cols, 0);
+            colWeightY.assign(cols, 0);
+            colPeak.assign(cols, 0);
+            colPeakY.assign(cols, -1);
+            colCenterY.assign(cols, -1.0f);
+        }
+    }
+
+    void LaserLineAccumulator::add(double x, double y)
+    {
+        n += 1;
+        sx += x;
+        sy += y;
+        sxx += x * x;
+        sxy += x * y;
+        syy += y * y;
+    }
+
+    // 抽样点取舍只由坐标决定：散列值低 log2(sampleStride) 位全为0的点保留
+    static inline uint32_t sampleHash(float x, float y)
+    {
+        uint32_t h = static_cast<uint32_t>(cvRound(x)) * 0x9E3779B1u ^ static_cast<uint32_t>(cvRound(y)) * 0x85EBCA77u;
+        h ^= h >> 16;
+        h *= 0x7FEB352Du;
+        h ^= h >> 15;
+        h *= 0x846CA68Bu;
+        h ^= h >> 16;
+        return h;
+    }
+
+    static inline bool keepSample(const cv::Point2f& p, size_t stride)
+    {
+        return (sampleHash(p.x, p.y) & static_cast<uint32_t>(stride - 1)) == 0;
+    }
+
+    // 步长翻倍：已保留的点按新步长重新筛选（约丢一半），顺序不变
+    static void raiseSampleStride(LaserLineAccumulator& acc, size_t stride)
+    {
+        acc.sampleStride = stride;
+        size_t kept = 0;
+        for (size_t i = 0; i < acc.sample.size(); ++i) {
+            if (keepSample(acc.sample[i], stride))
+                acc.sample[kept++] = acc.sample[i];
+        }
+        acc.sample.resize(kept);
+    }
+
+    void LaserLineAccumulator::addSample(float x, float y)
+    {
+        const cv::Point2f p(x, y);
+        if (sampleCapacity == 0 || !keepSample(p, sampleStride))
+            return;
+        while (sample.size() >= sampleCapacity) {
+            if (sampleStride >= (static_cast<size_t>(1) << 31))
+                return;
+            raiseSampleStride(*this, sampleStride * 2);
+            if (!keepSample(p, sampleStride))
+                return;
+        }
+        sample.push_back(p);
+    }
+
+    // 阈值模式：一行命中点（x升序）按行求整数和并记录行端点
+    static void accumulateThresholdRow(LaserLineAccumulator& acc, int y, const int* xs, int hits)
+    {
+        // 行内求和用整数，精确且与累加顺序无关
+        int64_t sumX = 0, sumXX = 0;
+        for (int i = 0; i < hits; ++i) {
+            int64_t x = xs[i];
+            sumX += x;
+            sumXX += x * x;
+        }
+        int64_t yy = y;
+        acc.n += hits;
+        acc.sx += static_cast<double>(sumX);
+        acc.sy += static_cast<double>(hits * yy);
+        acc.sxx += static_cast<double>(sumXX);
+        acc.sxy += static_cast<double>(sumX * yy);
+        acc.syy += static_cast<double>(hits * yy * yy);
+        acc.rowMinX[y] = xs[0];
+        acc.rowMaxX[y] = xs[hits - 1];
+        if (acc.sampleCapacity > 0) {
+            for (int i = 0; i < hits; ++i)
+                acc.addSample(static_cast<float>(xs[i]), static_cast<float>(y));
+        }
+    }
+
+    // 列模式：单个高于阈值的像素更新所在列的加权和与峰值
+    static inline void accumulateColumnPixel(LaserLineAccumulator& acc, int x, int y, int v, int thr)
+    {
+        acc.colWeight[x] += v - thr;
+        acc.colWeightY[x] += static_cast<int64_t>(v - thr) * y;
+        if (v > acc.colPeak[x]) {
+            acc.colPeak[x] = static_cast<uchar>(v);
+            acc.colPeakY[x] = y;
+        }
+    }
+
+    // 阈值模式：每行压缩出命中点后按行求整数和
+    template <class Pixels>
+    static size_t scanThresholdRows(const Pixels& px, int rowBegin, int rowEnd, const LaserDetectionOptions& options, LaserLineAccumulator& acc)
+    {
+        static const CompactRowFunc compactRow = selectCompactRow();
+
+        acc.rowBuf.resize(px.cols());
+        acc.rowXs.resize(px.cols());
+        size_t total = 0;
+        for (int y = rowBegin; y < rowEnd; ++y) {
+            const uchar* row = px.row(y, acc.rowBuf.data());
+            int hits = compactRow(row, 0, px.cols(), options.threshold, acc.rowXs.data());
+            if (hits == 0)
+                continue;
+            accumulateThresholdRow(acc, y, acc.rowXs.data(), hits);
+            total += hits;
+        }
+        return total;
+    }
+
+    // 列模式：逐行更新每列的加权和与峰值，访问顺序仍为行优先
+    template <class Pixels>
+    static size_t scanColumnRows(const Pixels& px, int rowBegin, int rowEnd, const LaserDetectionOptions& options, LaserLineAccumulator& acc)
+    {
+        acc.rowBuf.resize(px.cols());
+        const int thr = options.threshold;
+        size_t total = 0;
+        for (int y = rowBegin; y < rowEnd; ++y) {
+            const uchar* row = px.row(y, acc.rowBuf.data());
+            for (int x = 0; x < px.cols(); ++x) {
+                int v = row[x];
+                if (v <= thr)
+                    continue;
+                accumulateColumnPixel(acc, x, y, v, thr);
+                ++total;
+            }
+        }
+        return total;
+    }
+
+    uchar selectLaserThreshold(const std::vector<uint32_t>& histogram, const LaserDetectionOptions& options)
+    {
+        uint64_t total = 0;
+        for (int v = 0; v < 256; ++v)
+            total += histogram[v];
+        int thr = options.adaptiveMinThreshold;
+        if (total > 0 && options.thresholdMode == LaserThresholdMode::PERCENTILE) {
+            // 自高向低累计，取使“高于阈值的像素数”不超过上限的最小阈值
+            double ratio = std::min(std::max(100.0 - options.adaptivePercentile, 0.0), 100.0) / 100.0;
+            uint64_t limit = static_cast<uint64_t>(ratio * static_cast<double>(total));
+            uint64_t above = 0;
+            int t = 255;
+            while (t > 0 && above + histogram[t] <= limit) {
+                above += histogram[t];
+                --t;
+            }
+            thr = t;
+        } else if (total > 0 && options.thresholdMode == LaserThresholdMode::OTSU) {
+            // 类间方差最大：前景为强度 > t 的像素
+            double sumAll = 0;
+            for (int v = 0; v < 256; ++v)
+                sumAll += static_cast<double>(v) * histogram[v];
+            double sumBack = 0, bestVar = -1;
+            uint64_t back = 0;
+            for (int t = 0; t < 255; ++t) {
+                back += histogram[t];
+                sumBack += static_cast<double>(t) * histogram[t];
+                if (back == 0)
+                    continue;
+                uint64_t fore = total - back;
+                if (fore == 0)
+                    break;
+                double mb = sumBack / back;
+                double mf = (sumAll - sumBack) / fore;
+                double var = static_cast<double>(back) * fore * (mb - mf) * (mb - mf);
+                if (var > bestVar) {
+                    bestVar = var;
+                    thr = t;
+                }
+            }
+        }
+        return static_cast<uchar>(std::min(std::max(thr, static_cast<int>(options.adaptiveMinThreshold)), 254));
+    }
+
+    // 候选点缓冲按整个ROI分配，第 r 行固定从 r * candStride 处开始，各行带可并行写入互不重叠的行
+    static void reserveAdaptiveCandidates(int rows, int cols, LaserLineAccumulator& acc)
+    {
+        acc.candStride = adaptiveCandidateStride(cols);
+        acc.candX.resize(static_cast<size_t>(rows) * acc.candStride);
+        acc.candV.resize(acc.candX.size());
+        acc.candRowCount.resize(rows);
+    }
+
+    // 百分位按整个ROI的像素数计算：只扫描了行带（跟踪、粗到细）时，未扫描的行按背景计入最低档，
+    // 行带包含全部高于阈值的像素时，选出的阈值与扫描整个ROI相同
+    static void countUnscannedAsBackground(std::vector<uint32_t>& histogram, int rows, int cols, int rowBegin, int rowEnd,
+                                           const LaserDetectionOptions& options)
+    {
+        if (options.thresholdMode == LaserThresholdMode::PERCENTILE)
+            histogram[0] += static_cast<uint32_t>(rows - (rowEnd - rowBegin)) * static_cast<uint32_t>(cols);
+    }
+
+    // 自适应模式第一步：一次扫描同时统计强度直方图并压缩出高于下限的候选点（SIMD）
+    // 候选点写入 acc 的对应行；行缓冲、子直方图与直方图结果使用 part 的缓冲（行带并行时为各行带自己的累加器）
+    template <class Pixels>
+    static void collectAdaptiveCandidates(const Pixels& px, int rowBegin, int rowEnd, const LaserDetectionOptions& options,
+                                          LaserLineAccumulator& acc, LaserLineAccumulator& part)
+    {
+        static const CompactRowFunc compactRow = selectCompactRow();
+
+        const int cols = px.cols();
+        const int stride = acc.candStride;
+        part.rowBuf.resize(cols);
+        part.rowXs.resize(cols);
+        // 4组子直方图交替累加，避免相邻同值像素对同一计数器的写后读依赖
+        std::vector<uint32_t>& subHist = part.subHist;
+        subHist.assign(4 * 256, 0);
+        for (int y = rowBegin; y < rowEnd; ++y) {
+            const uchar* row = px.row(y, part.rowBuf.data());
+            int x = 0;
+            for (; x + 4 <= cols; x += 4) {
+                ++subHist[row[x]];
+                ++subHist[256 + row[x + 1]];
+                ++subHist[512 + row[x + 2]];
+                ++subHist[768 + row[x + 3]];
+            }
+            for (; x < cols; ++x)
+                ++subHist[row[x]];
+            const int hits = compactRow(row, 0, cols, options.adaptiveMinThreshold, part.rowXs.data());
+            if (hits > stride) {
+                acc.candRowCount[y] = -1; // 超出容量：回放时重新读取该行
+                continue;
+            }
+            uint16_t* xs = acc.candX.data() + static_cast<size_t>(y) * stride;
+            uchar* vs = acc.candV.data() + static_cast<size_t>(y) * stride;
+            for (int i = 0; i < hits; ++i) {
+                xs[i] = static_cast<uint16_t>(part.rowXs[i]);
+                vs[i] = row[part.rowXs[i]];
+            }
+            acc.candRowCount[y] = hits;
+        }
+        part.histogram.assign(256, 0);
+        for (int v = 0; v < 256; ++v)
+            part.histogram[v] = subHist[v] + subHist[256 + v] + subHist[512 + v] + subHist[768 + v];
+    }
+
+    // 自适应模式第二步：按选定阈值回放候选点，累加方式与固定阈值模式完全相同；只有超出候选容量的行重新读取图像
+    template <class Pixels>
+    static size_t replayAdaptiveCandidates(const Pixels& px, const LaserLineAccumulator& store, int rowBegin, int rowEnd, uchar thr,
+                                           const LaserDetectionOptions& options, LaserLineAccumulator& acc)
+    {
+        const int cols = px.cols();
+        acc.threshold = thr;
+        std::vector<int>& rowXs = acc.rowXs;
+        rowXs.resize(cols);
+        size_t total = 0;
+        for (int y = rowBegin; y < rowEnd; ++y) {
+            int hits = 0;
+            if (store.candRowCount[y] < 0) {
+                acc.rowBuf.resize(cols);
+                const uchar* row = px.row(y, acc.rowBuf.data());
+                for (int x = 0; x < cols; ++x) {
+                    if (row[x] <= thr)
+                        continue;
+                    if (options.extractionMode == LaserExtractionMode::THRESHOLD)
+                        rowXs[hits] = x;
+                    else
+                        accumulateColumnPixel(acc, x, y, row[x], thr);
+                    ++hits;
+                }
+            } else {
+                const uint16_t* xs = store.candX.data() + static_cast<size_t>(y) * store.candStride;
+                const uchar* vs = store.candV.data() + static_cast<size_t>(y) * store.candStride;
+                for (int i = 0; i < store.candRowCount[y]; ++i) {
+                    if (vs[i] <= thr)
+                        continue;
+                    if (options.extractionMode == LaserExtractionMode::THRESHOLD)
+                        rowXs[hits] = xs[i];
+                    else
+                        accumulateColumnPixel(acc, xs[i], y, vs[i], thr);
+                    ++hits;
+                }
+            }
+            if (hits > 0 && options.extractionMode == LaserExtractionMode::THRESHOLD)
+                accumulateThresholdRow(acc, y, rowXs.data(), hits);
+            total += hits;
+        }
+        return total;
+    }
+
+    void LaserLineAccumulator::merge(const LaserLineAccumulator& part, int rowBegin, int rowEnd)
+    {
+        n += part.n;
+        sx += part.sx;
+        sy += part.sy;
+        sxx += part.sxx;
+        sxy += part.sxy;
+        syy += part.syy;
+        if (!rowMinX.empty()) {
+            std::copy(part.rowMinX.begin() + rowBegin, part.rowMinX.begin() + rowEnd, rowMinX.begin() + rowBegin);
+            std::copy(part.rowMaxX.begin() + rowBegin, part.rowMaxX.begin() + rowEnd, rowMaxX.begin() + rowBegin);
+        }
+        const size_t cols = std::min(colWeight.size(), part.colWeight.size());
+        for (size_t x = 0; x < cols; ++x) {
+            colWeight[x] += part.colWeight[x];
+            colWeightY[x] += part.colWeightY[x];
+            // 行带按行序归并，峰值相同时保留较早的行，与顺序扫描一致
+            if (part.colPeak[x] > colPeak[x]) {
+                colPeak[x] = part.colPeak[x];
+                colPeakY[x] = part.colPeakY[x];
+            }
+        }
+        // 行带的抽样点是该行带全部点中满足其步长的子集；先升到行带的步长再逐点加入，
+        // 最终点集即全部点中满足最终步长的点（按行序），与顺序扫描相同
+        if (part.sampleStride > sampleStride)
+            raiseSampleStride(*this, part.sampleStride);
+        for (const cv::Point2f& p : part.sample)
+            addSample(p.x, p.y);
+    }
+
+    // 单线程扫描 [rowBegin, rowEnd)
+    template <class Pixels>
+    static size_t scanRowsSerial(const Pixels& px, int rowBegin, int rowEnd, const LaserDetectionOptions& options, LaserLineAccumulator& acc)
+    {
+        if (options.thresholdMode != LaserThresholdMode::FIXED) {
+            reserveAdaptiveCandidates(px.rows(), px.cols(), acc);
+            collectAdaptiveCandidates(px, rowBegin, rowEnd, options, acc, acc);
+            countUnscannedAsBackground(acc.histogram, px.rows(), px.cols(), rowBegin, rowEnd, options);
+            return replayAdaptiveCandidates(px, acc, rowBegin, rowEnd, selectLaserThreshold(acc.histogram, options), options, acc);
+        }
+        if (options.extractionMode == LaserExtractionMode::THRESHOLD)
+            return scanThresholdRows(px, rowBegin, rowEnd, options, acc);
+        return scanColumnRows(px, rowBegin, rowEnd, options, acc);
+    }
+
+    // 行带并行扫描的任务上下文：各任务只捕获上下文的引用，std::function 无需为捕获列表申请堆内存
+    template <class Pixels>
+    struct BandScan {
+        const Pixels& px;
+        const LaserDetectionOptions& options;
+        LaserLineAccumulator& acc;
+        int rowBegin, rowEnd, bandRows;
+        uchar thr;
+
+        int bandBegin(int b) const { return rowBegin + b * bandRows; }
+        int bandEnd(int b) const { return std::min(rowEnd, rowBegin + (b + 1) * bandRows); }
+    };
+
+    // 行带并行扫描：行带划分只取决于 bandRows，各行带写入各自的部分累加器，最后按行带顺序归并，
+    // 因此结果与线程数及任务调度顺序无关。部分累加器保存在 acc.bands 中跨帧复用
+    template <class Pixels>
+    static size_t scanRowsBanded(const Pixels& px, int rowBegin, int rowEnd, const LaserDetectionOptions& options, LaserLineAccumulator& acc)
+    {
+        const int bandRows = std::max(options.bandRows, 1);
+        const int bandCount = (rowEnd - rowBegin + bandRows - 1) / bandRows;
+        if (acc.bands.size() < static_cast<size_t>(bandCount))
+            acc.bands.resize(bandCount);
+        acc.bandTotals.assign(bandCount, 0);
+        BandScan<Pixels> job{px, options, acc, rowBegin, rowEnd, bandRows, 0};
+
+        if (options.thresholdMode == LaserThresholdMode::FIXED) {
+            options.workerPool->run(bandCount, [&job](int b) {
+                LaserLineAccumulator& part = job.acc.bands[b];
+                part.reset(job.px.rows(), job.px.cols(), job.options.extractionMode, job.acc.sampleCapacity);
+                job.acc.bandTotals[b] = scanRowsSerial(job.px, job.bandBegin(b), job.bandEnd(b), job.options, part);
+            });
+        } else {
+            // 自适应模式：各行带统计直方图并把候选点写入 acc 的对应行，按行带顺序汇总直方图选定阈值后再并行回放
+            reserveAdaptiveCandidates(px.rows(), px.cols(), acc);
+            options.workerPool->run(bandCount, [&job](int b) {
+                LaserLineAccumulator& part = job.acc.bands[b];
+                part.reset(job.px.rows(), job.px.cols(), job.options.extractionMode, job.acc.sampleCapacity);
+                collectAdaptiveCandidates(job.px, job.bandBegin(b), job.bandEnd(b), job.options, job.acc, part);
+            });
+            acc.histogram.assign(256, 0);
+            for (int b = 0; b < bandCount; ++b) {
+                for (int v = 0; v < 256; ++v)
+                    acc.histogram[v] += acc.bands[b].histogram[v];
+            }
+            countUnscannedAsBackground(acc.histogram, px.rows(), px.cols(), rowBegin, rowEnd, options);
+            job.thr = selectLaserThreshold(acc.histogram, options);
+            acc.threshold = job.thr;
+            options.workerPool->run(bandCount, [&job](int b) {
+                job.acc.bandTotals[b] = replayAdaptiveCandidates(job.px, job.acc, job.bandBegin(b), job.bandEnd(b), job.thr, job.options, job.acc.bands[b]);
+            });
+        }
+
+        size_t total = 0;
+        for (int b = 0; b < bandCount; ++b) {
+            acc.merge(acc.bands[b], job.bandBegin(b), job.bandEnd(b));
+            total += acc.bandTotals[b];
+        }
+        return total;
+    }
+
+    size_t scanLaserLine(const cv::Mat& roiView, int rowBegin, int rowEnd, const LaserDetectionOptions& options, LaserLineAccumulator& acc)
+    {
+        acc.threshold = options.threshold;
+        if (!isSupportedLaserImageType(roiView.type()))
+            return 0;
+        return withPixels(roiView, options, [&](const auto& px) {
+            if (options.workerPool != nullptr && rowEnd > rowBegin)
+                return scanRowsBanded(px, rowBegin, rowEnd, options, acc);
+            return scanRowsSerial(px, rowBegin, rowEnd, options, acc);
+        });
+    }
+
+    template <class Pixels>
+    static bool locateBand(const Pixels& px, const LaserDetectionOptions& options, int& rowBegin, int& rowEnd)
+    {
+        const int f = options.pyramidFactor;
+
+        // 粗网格只读取 1/(f*f) 的像素，记录命中行的范围（自适应模式下用阈值下限，阈值在精细扫描中选定）
+        const int thr = options.thresholdMode == LaserThresholdMode::FIXED ? options.threshold : options.adaptiveMinThreshold;
+        int minRow = -1, maxRow = -1;
+        for (int y = f / 2; y < px.rows(); y += f) {
+            bool hit = false;
+            for (int x = f / 2; x < px.cols() && !hit; x += f)
+                hit = px.at(x, y) > thr;
+            if (!hit)
+                continue;
+            if (minRow < 0)
+                minRow = y;
+            maxRow = y;
+        }
+        if (minRow < 0)
+            return false;
+
+        // 相邻粗网格行之间的像素未被采样，带宽向外扩展一个步长再加余量
+        rowBegin = std::max(0, minRow - f - options.pyramidMargin);
+        rowEnd = std::min(px.rows(), maxRow + f + options.pyramidMargin + 1);
+        return true;
+    }
+
+    template <class Pixels>
+    static bool prescanPixels(const Pixels& px, const LaserDetectionOptions& options)
+    {
+        const int rowStep = std::max(options.prescanRowStep, 1);
+        const int colStep = std::max(options.prescanColStep, 1);
+        const int thr = options.thresholdMode == LaserThresholdMode::FIXED ? options.threshold : options.adaptiveMinThreshold;
+        const int minHits = std::max(options.prescanMinHits, 1);
+        int hits = 0;
+        for (int y = rowStep / 2; y < px.rows(); y += rowStep) {
+            for (int x = colStep / 2; x < px.cols(); x += colStep) {
+                if (px.at(x, y) > thr && ++hits >= minHits)
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    bool prescanLaserEvidence(const cv::Mat& roiView, const LaserDetectionOptions& options)
+    {
+        if (!isSupportedLaserImageType(roiView.type()))
+            return false;
+        return withPixels(roiView, options, [&](const auto& px) { return prescanPixels(px, options); });
+    }
+
+    bool locateLaserBand(const cv::Mat& roiView, const LaserDetectionOptions& options, int& rowBegin, int& rowEnd)
+    {
+        rowBegin = 0;
+        rowEnd = roiView.rows;
+        if (options.pyramidFactor <= 1 || !isSupportedLaserImageType(roiView.type()))
+            return false;
+        return withPixels(roiView, options, [&](const auto& px) { return locateBand(px, options, rowBegin, rowEnd); });
+    }
+
+    template <class Pixels>
+    static void finishColumns(const Pixels& px, const LaserDetectionOptions& options, LaserLineAccumulator& acc)
+    {
+        for (int x = 0; x < static_cast<int>(acc.colWeight.size()); ++x) {
+            if (acc.colWeight[x] == 0)
+                continue;
+            double center = static_cast<double>(acc.colWeightY[x]) / acc.colWeight[x];
+            int py = acc.colPeakY[x];
+            if (options.extractionMode == LaserExtractionMode::COLUMN_PEAK && py > 0 && py < px.rows() - 1) {
+                int a = px.at(x, py - 1);
+                int b = acc.colPeak[x];
+                int c = px.at(x, py + 1);
+                int denom = a - 2 * b + c;
+                // 平顶（饱和）时峰值不唯一，保留重心结果
+                if (a < b && c < b && denom != 0)
+                    center = py + 0.5 * (a - c) / denom;
+            }
+            acc.colCenterY[x] = static_cast<float>(center);
+            acc.add(x, center);
+            acc.addSample(static_cast<float>(x), static_cast<float>(center));
+        }
+    }
+
+    size_t finishLaserScan(const cv::Mat& roiView, const LaserDetectionOptions& options, LaserLineAccumulator& acc)
+    {
+        if (options.extractionMode != LaserExtractionMode::THRESHOLD && isSupportedLaserImageType(roiView.type()))
+            withPixels(roiView, options, [&](const auto& px) { finishColumns(px, options, acc); });
+        return static_cast<size_t>(acc.n);
+    }
+
+    // 由矩闭式求主方向与RMS（与 OpenCV fitLine2D_wods 相同的公式）
+    static void solveMoments(const LaserLineAccumulator& acc, LaserLineFit& fit)
+    {
+        double x = acc.sx / acc.n;
+        double y = acc.sy / acc.n;
+        double dx2 = acc.sxx / acc.n - x * x;
+        double dy2 = acc.syy / acc.n - y * y;
+        double dxy = acc.sxy / acc.n - x * y;
+
+        float t = static_cast<float>(std::atan2(2 * dxy, dx2 - dy2)) / 2;
+        float vx = static_cast<float>(std::cos(static_cast<double>(t)));
+        float vy = static_cast<float>(std::sin(static_cast<double>(t)));
+        float x0 = static_cast<float>(x);
+        float y0 = static_cast<float>(y);
+        fit.line = cv::Vec4f(vx, vy, x0, y0);
+
+        // RMS：以(x0, y0)为中心的二阶矩投影到法向
+        double ox = x - x0, oy = y - y0;
+        double cxx = dx2 + ox * ox, cyy = dy2 + oy * oy, cxy = dxy + ox * oy;
+        double norm2 = static_cast<double>(vx) * vx + static_cast<double>(vy) * vy;
+        double meanDist2 = (vy * vy * cxx - 2.0 * vx * vy * cxy + vx * vx * cyy) / norm2;
+        fit.rms = std::sqrt(std::max(meanDist2, 0.0));
+    }
+
+    bool solveLaserLine(const LaserLineAccumulator& acc, LaserLineFit& fit)
+    {
+        if (acc.n < 2)
+            return false;
+        solveMoments(acc, fit);
+        fit.count = static_cast<size_t>(acc.n);
+        fit.inliers = static_cast<int>(acc.n);
+        fit.iterations = 1;
+        const float vx = fit.line[0], vy = fit.line[1], x0 = fit.line[2], y0 = fit.line[3];
+
+        // 投影范围：同一行内投影随x单调，极值必在该行最左/最右命中点
+        fit.minProj = std::numeric_limits<double>::max();
+        fit.maxProj = std::numeric_limits<double>::lowest();
+        for (size_t c = 0; c < acc.colCenterY.size(); ++c) {
+            if (acc.colCenterY[c] < 0)
+                continue;
+            double p = (static_cast<double>(c) - x0) * vx + (acc.colCenterY[c] - y0) * vy;
+            fit.minProj = std::min(fit.minProj, p);
+            fit.maxProj = std::max(fit.maxProj, p);
+        }
+        for (size_t r = 0; r < acc.rowMinX.size(); ++r) {
+            if (acc.rowMinX[r] < 0)
+                continue;
+            double py = (static_cast<double>(r) - y0) * vy;
+            double p1 = (acc.rowMinX[r] - x0) * vx + py;
+            double p2 = (acc.rowMaxX[r] - x0) * vx + py;
+            fit.minProj = std::min(fit.minProj, std::min(p1, p2));
+            fit.maxProj = std::max(fit.maxProj, std::max(p1, p2));
+        }
+        return true;
+    }
+
+    bool robustFitLaserLine(const LaserLineAccumulator& acc, const LaserDetectionOptions& options, LaserLineFit& fit)
+    {
+        const std::vector<cv::Point2f>& pts = acc.sample;
+        const int count = static_cast<int>(pts.size());
+        if (count < 2)
+            return false;
+
+        typedef std::chrono::steady_clock Clock;
+        const Clock::time_point deadline = Clock::now() + std::chrono::microseconds(options.ransacTimeBudgetUs);
+        const float maxDist = options.ransacInlierDistance;
+        const int target = static_cast<int>(std::ceil(options.ransacTargetInlierRatio * count));
+        std::mt19937 rng(20240601u); // 固定种子，同一帧结果可复现
+
+        int bestInliers = 0;
+        float bestNx = 0, bestNy = 0, bestC = 0;
+        int iterations = 0;
+        while (iterations < options.ransacMaxIterations && bestInliers < target) {
+            // 首次迭代总会执行，之后每次迭代前检查时间预算
+            if (iterations > 0 && Clock::now() >= deadline)
+                break;
+            ++iterations;
+            const cv::Point2f& p = pts[rng() % count];
+            const cv::Point2f& q = pts[rng() % count];
+            float dx = q.x - p.x, dy = q.y - p.y;
+            float len = std::sqrt(dx * dx + dy * dy);
+            if (len < 1.0f)
+                continue;
+            float nx = -dy / len, ny = dx / len;
+            float c = -(nx * p.x + ny * p.y);
+            int inliers = 0;
+            for (int i = 0; i < count; ++i)
+                inliers += std::abs(nx * pts[i].x + ny * pts[i].y + c) <= maxDist;
+            if (inliers > bestInliers) {
+                bestInliers = inliers;
+                bestNx = nx;
+                bestNy = ny;
+                bestC = c;
+            }
+        }
+        if (bestInliers < 2)
+            return false;
+
+        // 对内点做最小二乘精修，RMS与投影范围只统计内点
+        LaserLineAccumulator inlierAcc;
+        for (int i = 0; i < count; ++i) {
+            if (std::abs(bestNx * pts[i].x + bestNy * pts[i].y + bestC) <= maxDist)
+                inlierAcc.add(pts[i].x, pts[i].y);
+        }
+        solveMoments(inlierAcc, fit);
+        fit.count = static_cast<size_t>(acc.n);
+        fit.inliers = bestInliers;
+        fit.iterations = iterations;
+
+        const float vx = fit.line[0], vy = fit.line[1], x0 = fit.line[2], y0 = fit.line[3];
+        fit.minProj = std::numeric_limits<double>::max();
+        fit.maxProj = std::numeric_limits<double>::lowest();
+        for (int i = 0; i < count; ++i) {
+            if (std::abs(bestNx * pts[i].x + bestNy * pts[i].y + bestC) > maxDist)
+                continue;
+            double p = (pts[i].x - x0) * vx + (pts[i].y - y0) * vy;
+            fit.minProj = std::min(fit.minProj, p);
+            fit.maxProj = std::max(fit.maxProj, p);
+        }
+        return true;
+    }
+
+} // namespace LidarLineDetector
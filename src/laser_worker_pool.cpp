@@ -0,0 +1,95 @@
+#include "lidar_line_detection.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+// 激光线检测行带并行线程池
+namespace LidarLineDetector {
+
+    struct LaserWorkerPool::Impl {
+        std::vector<std::thread> threads;
+        std::mutex runMutex; // 同一时刻只服务一个 run
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable done;
+        const std::function<void(int)>* task = nullptr;
+        int taskCount = 0;
+        std::atomic<int> next{0};
+        int active = 0;
+        uint64_t generation = 0;
+        bool stop = false;
+
+        // 领取任务直到全部分发完毕
+        void drain()
+        {
+            for (int i = next.fetch_add(1); i < taskCount; i = next.fetch_add(1))
+                (*task)(i);
+        }
+
+        void workerLoop()
+        {
+            uint64_t seen = 0;
+            for (;;) {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wake.wait(lock, [&] { return stop || generation != seen; });
+                    if (stop)
+                        return;
+                    seen = generation;
+                }
+                drain();
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--active == 0)
+                    done.notify_one();
+            }
+        }
+    };
+
+    LaserWorkerPool::LaserWorkerPool(int threads) : m_impl(new Impl)
+    {
+        for (int i = 1; i < threads; ++i)
+            m_impl->threads.emplace_back([this] { m_impl->workerLoop(); });
+    }
+
+    LaserWorkerPool::~LaserWorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_impl->mutex);
+            m_impl->stop = true;
+        }
+        m_impl->wake.notify_all();
+        for (std::thread& t : m_impl->threads)
+            t.join();
+    }
+
+    int LaserWorkerPool::threadCount() const
+    {
+        return static_cast<int>(m_impl->threads.size()) + 1;
+    }
+
+    void LaserWorkerPool::run(int taskCount, const std::function<void(int)>& task)
+    {
+        Impl& impl = *m_impl;
+        std::unique_lock<std::mutex> runLock(impl.runMutex, std::try_to_lock);
+        if (impl.threads.empty() || taskCount <= 1 || !runLock.owns_lock()) {
+            for (int i = 0; i < taskCount; ++i)
+                task(i);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(impl.mutex);
+            impl.task = &task;
+            impl.taskCount = taskCount;
+            impl.next.store(0);
+            impl.active = static_cast<int>(impl.threads.size());
+            ++impl.generation;
+        }
+        impl.wake.notify_all();
+        impl.drain(); // 调用线程同样参与
+        std::unique_lock<std::mutex> lock(impl.mutex);
+        impl.done.wait(lock, [&] { return impl.active == 0; });
+        impl.task = nullptr;
+    }
+
+} // namespace LidarLineDetector
@@ -1,12 +1,15 @@
 #include "lidar_line_detection.h"
+#include <functional>
 #include <iostream>
 #include <fstream>
-#include <ctime>
 #include <cstdint>
 #include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <cctype>
 #include "spdlog/spdlog.h"
 #include "spdlog/sinks/basic_file_sink.h"
-#include <direct.h> // Windows下创建文件夹
 
 using namespace cv;
 using namespace std;
@@ -15,10 +18,44 @@ using namespace std;
 namespace LidarLineDetector {
 
     // 版本信息实现
-    static const char *versionString = "1.0.0";
+    static const char *versionString = "2.0.0";
 
     static std::shared_ptr<spdlog::logger> logger = spdlog::basic_logger_mt("lidar_logger", "log/lidar_line_detection.log");
 
+    // 检测日志：实例设置了相机ID时写入该相机的日志，否则写入共享日志
+    static spdlog::logger& logOf(const LaserDetectionOptions& options)
+    {
+        return options.logger != nullptr ? *options.logger : *logger;
+    }
+
+    // 相机日志：名称 lidar_<相机ID>，文件 log/lidar_<相机ID>.log。ID中字母、数字、'-'、'_' 以外的字节
+    // （含'%'本身）转义为 %XX，转义可逆，不同ID（如 "A/1" 与 "A_1"）不会落到同一日志与文件。
+    // 同一ID只创建一次，之后的实例复用同一日志，避免两个文件句柄交错写同一文件
+    std::shared_ptr<spdlog::logger> cameraLogger(const std::string& cameraId)
+    {
+        static std::mutex creationMutex;
+        static const char hex[] = "0123456789ABCDEF";
+        std::string safeId;
+        for (char c : cameraId)
+        {
+            const unsigned char u = static_cast<unsigned char>(c);
+            if (std::isalnum(u) || c == '-' || c == '_')
+            {
+                safeId += c;
+                continue;
+            }
+            safeId += '%';
+            safeId += hex[u >> 4];
+            safeId += hex[u & 0xF];
+        }
+        const std::string name = "lidar_" + safeId;
+        std::lock_guard<std::mutex> lock(creationMutex);
+        std::shared_ptr<spdlog::logger> existing = spdlog::get(name);
+        if (existing)
+            return existing;
+        return spdlog::basic_logger_mt(name, "log/" + name + ".log");
+    }
+
     VersionInfo getVersionInfo()
     {
         return {
@@ -48,8 +85,18 @@ namespace LidarLineDetector {
         return LIDAR_LINE_DETECTION_VERSION_PATCH;
     }
 
-    // 读取ROI配置文件
+    // 读取ROI配置文件（取第一个ROI）
     DetectionResultCode readROIFromConfig(const string &configPath, ROI &roi)
+    {
+        std::vector<ROI> rois;
+        DetectionResultCode code = readROIsFromConfig(configPath, rois);
+        if (code == DetectionResultCode::SUCCESS)
+            roi = rois.front();
+        return code;
+    }
+
+    // 读取多ROI配置文件：依次出现的 x/y/width/height 为一组，某个键再次出现即开始下一组
+    DetectionResultCode readROIsFromConfig(const string &configPath, std::vector<ROI> &rois)
     {
         logger->info("开始读取ROI配置文件: {}", configPath);
         ifstream configFile(configPath);
@@ -60,62 +107,428 @@ namespace LidarLineDetector {
             return DetectionResultCode::CONFIG_LOAD_FAILED;
         }
 
+        rois.clear();
         string line;
+        ROI roi{0, 0, 0, 0};
         bool xRead = false, yRead = false, widthRead = false, heightRead = false;
+        bool complete = true;
+        auto finishGroup = [&]() {
+            if (!xRead && !yRead && !widthRead && !heightRead)
+                return;
+            if (xRead && yRead && widthRead && heightRead)
+                rois.push_back(roi);
+            else
+                complete = false;
+            xRead = yRead = widthRead = heightRead = false;
+        };
 
         while (getline(configFile, line))
         {
             if (line.find("x:") == 0)
             {
+                if (xRead)
+                    finishGroup();
                 sscanf(line.c_str(), "x: %d", &roi.x);
                 xRead = true;
             }
             else if (line.find("y:") == 0)
             {
+                if (yRead)
+                    finishGroup();
                 sscanf(line.c_str(), "y: %d", &roi.y);
                 yRead = true;
             }
             else if (line.find("width:") == 0)
             {
+                if (widthRead)
+                    finishGroup();
                 sscanf(line.c_str(), "width: %d", &roi.width);
                 widthRead = true;
             }
             else if (line.find("height:") == 0)
             {
+                if (heightRead)
+                    finishGroup();
                 sscanf(line.c_str(), "height: %d", &roi.height);
                 heightRead = true;
             }
         }
         configFile.close();
+        finishGroup();
 
-        if (!xRead || !yRead || !widthRead || !heightRead)
+        if (!complete || rois.empty())
             return DetectionResultCode::CONFIG_LOAD_FAILED;
-        if (roi.width <= 0 || roi.height <= 0)
-            return DetectionResultCode::ROI_INVALID;
-        logger->info("ROI配置读取成功: x={}, y={}, w={}, h={}", roi.x, roi.y, roi.width, roi.height);
+        for (const ROI &r : rois)
+        {
+            if (r.width <= 0 || r.height <= 0)
+                return DetectionResultCode::ROI_INVALID;
+            logger->info("ROI配置读取成功: x={}, y={}, w={}, h={}", r.x, r.y, r.width, r.height);
+        }
         return DetectionResultCode::SUCCESS;
     }
 
-    // 生成带时间和SN的文件名
-    string generateFileName(const string &basePath, const string &sn)
+    // 按保存策略判定本帧是否输出结果图，每帧只调用一次（抽样与限速计数在此推进）
+    static bool wantArtifact(const LaserDetectionOptions& options, bool failed)
     {
-        time_t now = time(0);
-        char timeStr[26];
-        ctime_s(timeStr, sizeof(timeStr), &now);
-        for (int i = 0; timeStr[i]; i++)
-            if (timeStr[i] == ' ' || timeStr[i] == ':' || timeStr[i] == '\n')
-                timeStr[i] = '_';
-        return basePath + "_" + sn + "_" + timeStr + ".jpg";
+        const LaserArtifactPolicy& policy = options.artifactPolicy;
+        if (policy.trigger == LaserArtifactTrigger::NEVER || (policy.trigger == LaserArtifactTrigger::FAILURES_ONLY && !failed))
+            return false;
+        return options.artifactBudget == nullptr || options.artifactBudget->admit(policy);
+    }
+
+    // 保存一张结果图：src 中的画布区域（全图，或策略要求裁剪时为 focus 外扩后的区域）转为8位BGR
+    // （单通道/16位/Bayer图像均转换，保证标注颜色可见），由 draw 绘制（origin 为画布左上角的全图坐标），
+    // 再按策略缩放并编码一次；同步写盘，或绘制在异步写盘器的池化缓冲中后入队。配置了会话视频时追加为视频帧。
+    // 返回图像路径（异步时为预留路径；会话视频同步时为"分段文件#帧序号"，异步时为会话索引路径），未保存返回空串；
+    // 生成结果图（转换、绘制、缩放）或同步写盘（追加视频帧）失败时置 saveFailed，OpenCV 异常不向外抛出
+    static std::string saveOverlay(const cv::Mat& src, const cv::Rect& focus, const LaserDetectionOptions& options,
+                                   const std::string& outputDir, const std::string& sn, bool failed,
+                                   const std::function<void(cv::Mat&, const cv::Point&)>& draw, bool* saveFailed = nullptr)
+    {
+        const LaserArtifactPolicy& policy = options.artifactPolicy;
+        const cv::Rect imageRect(0, 0, src.cols, src.rows);
+        cv::Rect canvasRect = imageRect;
+        if (policy.cropToROI)
+        {
+            const int margin = std::max(policy.cropMargin, 0);
+            cv::Rect cropRect = cv::Rect(focus.x - margin, focus.y - margin, focus.width + 2 * margin, focus.height + 2 * margin) & imageRect;
+            if (!cropRect.empty())
+                canvasRect = cropRect;
+        }
+        const bool thumbnail = policy.scale > 0.0f && policy.scale < 1.0f;
+        const bool png = policy.format == LaserArtifactFormat::PNG;
+        const std::vector<int> params = png
+            ? std::vector<int>{cv::IMWRITE_PNG_COMPRESSION, std::min(std::max(policy.pngCompression, 0), 9)}
+            : std::vector<int>{cv::IMWRITE_JPEG_QUALITY, std::min(std::max(policy.jpegQuality, 0), 100)};
+        // 文件名只在真正写出图像文件时生成：追加会话视频或丢弃时不消耗序号，也不创建分片目录
+        // 失败图像以 result_fail_ 为前缀，保留策略重启扫描时据此恢复失败标记
+        auto makeFileName = [&] { return generateFileName(outputDir + (failed ? "/result_fail" : "/result"), sn, png ? ".png" : ".jpg"); };
+
+        // 转换或绘制失败（如不支持的格式、奇数尺寸的Bayer裁剪区域）返回false；OpenCV 异常由调用处捕获
+        auto render = [&](cv::Mat& out) {
+            if (!thumbnail)
+            {
+                if (!convertToBGR(src(canvasRect), options.bayerPattern, out, options.mono16Shift))
+                    return false;
+                draw(out, canvasRect.tl());
+                return true;
+            }
+            cv::Mat canvas;
+            if (!convertToBGR(src(canvasRect), options.bayerPattern, canvas, options.mono16Shift))
+                return false;
+            draw(canvas, canvasRect.tl());
+            cv::Size size(std::max(cvRound(canvas.cols * policy.scale), 1), std::max(cvRound(canvas.rows * policy.scale), 1));
+            cv::resize(canvas, out, size, 0, 0, cv::INTER_AREA);
+            return true;
+        };
+        // 结果图失败不影响检测结果本身：记录日志并置 saveFailed，由调用方返回 IMAGE_SAVE_FAILED，异常不越过C接口
+        auto fail = [&](const char* what) {
+            logOf(options).error("生成结果图失败，SN: {} ({})", sn, what);
+            if (saveFailed != nullptr)
+                *saveFailed = true;
+            return std::string();
+        };
+
+        if (options.artifactWriter != nullptr)
+        {
+            cv::Mat* buffer = options.artifactWriter->acquire();
+            if (buffer == nullptr)
+            {
+                logOf(options).warn("输出队列已满，丢弃图像，SN: {}", sn);
+                return "";
+            }
+            // 绘制失败时归还缓冲，否则池中缓冲逐次流失，之后每帧都被丢弃
+            bool rendered = false;
+            try
+            {
+                rendered = render(*buffer);
+            }
+            catch (const cv::Exception& e)
+            {
+                options.artifactWriter->release(buffer);
+                return fail(e.what());
+            }
+            if (!rendered)
+            {
+                options.artifactWriter->release(buffer);
+                return fail("图像格式转换失败");
+            }
+            if (options.videoSink != nullptr)
+            {
+                options.artifactWriter->submit(buffer, options.videoSink, sn);
+                return options.videoSink->indexPath();
+            }
+            const std::string fileName = makeFileName();
+            options.artifactWriter->submit(buffer, fileName, params, options.retention, failed);
+            return fileName;
+        }
+
+        try
+        {
+            cv::Mat overlay;
+            if (!render(overlay))
+                return fail("图像格式转换失败");
+            if (options.videoSink != nullptr)
+            {
+                std::string location;
+                if (!options.videoSink->append(overlay, sn, location))
+                    return fail("追加会话视频帧失败");
+                return location;
+            }
+            const std::string fileName = makeFileName();
+            if (!cv::imwrite(fileName, overlay, params))
+            {
+                logOf(options).error("保存图像失败: {}", fileName);
+                if (saveFailed != nullptr)
+                    *saveFailed = true;
+                return "";
+            }
+            logOf(options).info("图像已保存: {}", fileName);
+            if (options.retention != nullptr)
+                options.retention->track(fileName, failed);
+            return fileName;
+        }
+        catch (const cv::Exception& e)
+        {
+            return fail(e.what());
+        }
+    }
+
+    // 单ROI结果图：ROI框（成功绿色/失败红色），detail 在ROI坐标系内补充绘制（roiOrigin 为ROI左上角的画布坐标），
+    // 失败时左上角写出 failureText() 给出的原因。按保存策略不保存时返回空串
+    // 原因文字与绘制回调都在确定保存后才求值/包装，不保存的帧不产生任何堆分配
+    template <class FailureText, class Detail>
+    static std::string saveDetectionImage(const cv::Mat& image, const cv::Rect& roiRect, const LaserDetectionOptions& options,
+                                          const std::string& outputDir, const std::string& sn, bool failed,
+                                          const FailureText& failureText, const Detail& detail, bool* saveFailed = nullptr)
+    {
+        if (outputDir.empty() || !wantArtifact(options, failed))
+            return "";
+        return saveOverlay(image, roiRect, options, outputDir, sn, failed, [&](cv::Mat& canvas, const cv::Point& origin) {
+            cv::rectangle(canvas, roiRect - origin, failed ? cv::Scalar(0, 0, 255) : cv::Scalar(0, 255, 0), 2);
+            detail(canvas, roiRect.tl() - origin);
+            if (failed)
+                cv::putText(canvas, failureText(), cv::Point(20, 30), cv::FONT_HERSHEY_SIMPLEX, 0.7, cv::Scalar(0, 0, 255), 2);
+        }, saveFailed);
+    }
+
+    // 只有ROI框与固定原因文字的失败结果图
+    static std::string saveDetectionImage(const cv::Mat& image, const cv::Rect& roiRect, const LaserDetectionOptions& options,
+                                          const std::string& outputDir, const std::string& sn, const char* failureText)
+    {
+        return saveDetectionImage(image, roiRect, options, outputDir, sn, true, [&] { return std::string(failureText); },
+                                  [](cv::Mat&, const cv::Point&) {});
+    }
+
+    // 绘制拟合直线段，端点取点集在直线方向上的投影范围；roiOrigin 为ROI左上角在画布中的坐标
+    static void drawLaserSegment(cv::Mat& canvas, const LaserLineFit& fit, const cv::Point& roiOrigin)
+    {
+        float vx = fit.line[0], vy = fit.line[1], x0 = fit.line[2], y0 = fit.line[3];
+        // 计算直线段的两个端点（ROI内坐标）
+        cv::Point pt1_roi(x0 + fit.minProj * vx, y0 + fit.minProj * vy);
+        cv::Point pt2_roi(x0 + fit.maxProj * vx, y0 + fit.maxProj * vy);
+        // 转为画布坐标
+        cv::line(canvas, pt1_roi + roiOrigin, pt2_roi + roiOrigin, cv::Scalar(0, 0, 255), 2, cv::LINE_AA);
+    }
+
+    // 标出提取的激光点（阈值模式重新提取坐标，列模式绘制各列中心）
+    static void drawLaserPoints(cv::Mat& canvas, const cv::Point& roiOrigin, const cv::Mat& roiView, const LaserDetectionOptions& options,
+                                int threshold, const LaserLineAccumulator& acc)
+    {
+        if (!options.artifactPolicy.drawPoints)
+            return;
+        const cv::Scalar color(0, 255, 255);
+        if (options.extractionMode == LaserExtractionMode::THRESHOLD) {
+            LaserPointSet laserPoints;
+            extractLaserPoints(roiView, options, static_cast<uchar>(threshold), laserPoints);
+            for (size_t i = 0; i < laserPoints.count; ++i)
+                cv::circle(canvas, roiOrigin + cv::Point(laserPoints.xs[i], laserPoints.ys[i]), 1, color, -1);
+        } else {
+            for (size_t x = 0; x < acc.colCenterY.size(); ++x) {
+                if (acc.colCenterY[x] >= 0)
+                    cv::circle(canvas, roiOrigin + cv::Point(static_cast<int>(x), cvRound(acc.colCenterY[x])), 1, color, -1);
+            }
+        }
+    }
+
+    // 一次扫描+拟合+判据评估的结果
+    struct LaserScanOutcome {
+        DetectionResultCode status; // SUCCESS / NOT_FOUND（点数不足或拟合失败）/ OUT_OF_ROI（RMS或长度不达标）
+        size_t pointCount;
+        int threshold;      // 实际使用的阈值
+        bool prescanRejected; // 稀疏预扫描判定为空帧，未做完整扫描
+        LaserLineFit fit;
+    };
+
+    // 扫描ROI的[rowBegin, rowEnd)行并拟合直线，按点数、RMS、投影长度三个判据给出状态
+    // 单次扫描：强度换算、阈值比较（SIMD）与矩累加同时完成，不保存点集；列模式下每列只保留一个亚像素中心
+    static LaserScanOutcome scanAndFit(const cv::Mat& roiView, const ROI& roi, const LaserDetectionOptions& options,
+                                       int rowBegin, int rowEnd, LaserLineAccumulator& acc)
+    {
+        LaserScanOutcome outcome;
+        outcome.status = DetectionResultCode::NOT_FOUND;
+        outcome.prescanRejected = false;
+        outcome.fit = LaserLineFit();
+
+        size_t sampleCapacity = options.fitMode == LaserFitMode::RANSAC ? static_cast<size_t>(std::max(options.ransacMaxSamples, 2)) : 0;
+        acc.reset(roiView.rows, roiView.cols, options.extractionMode, sampleCapacity);
+        scanLaserLine(roiView, rowBegin, rowEnd, options, acc);
+        outcome.threshold = acc.threshold;
+        outcome.pointCount = finishLaserScan(roiView, options, acc);
+        if (outcome.pointCount < 10)
+            return outcome;
+
+        // 由累加矩闭式求解直线（等价于 fitLine DIST_L2），或在抽样点上做有界RANSAC
+        bool fitted = (options.fitMode == LaserFitMode::RANSAC) ? robustFitLaserLine(acc, options, outcome.fit) : solveLaserLine(acc, outcome.fit);
+        if (!fitted)
+            return outcome;
+
+        double length = outcome.fit.maxProj - outcome.fit.minProj;
+        outcome.status = (outcome.fit.rms > 5.0 || length < roi.width * 0.5) ? DetectionResultCode::OUT_OF_ROI : DetectionResultCode::SUCCESS;
+        return outcome;
+    }
+
+    // 成功时记录直线段覆盖的行范围（ROI坐标），失败时清除跟踪
+    static void updateTrackingState(LaserTrackingState& tracking, const ROI& roi, const LaserScanOutcome& outcome)
+    {
+        if (outcome.status != DetectionResultCode::SUCCESS)
+        {
+            tracking.valid = false;
+            ++tracking.misses;
+            return;
+        }
+        const LaserLineFit& fit = outcome.fit;
+        double y1 = fit.line[3] + fit.minProj * fit.line[1];
+        double y2 = fit.line[3] + fit.maxProj * fit.line[1];
+        tracking.valid = true;
+        tracking.roiX = roi.x;
+        tracking.roiY = roi.y;
+        tracking.roiWidth = roi.width;
+        tracking.roiHeight = roi.height;
+        tracking.lineTop = cvFloor(std::min(y1, y2));
+        tracking.lineBottom = cvCeil(std::max(y1, y2));
+        ++tracking.hits;
+    }
+
+    // 在ROI视图上完成一次检测（不含图像输出）
+    // 跟踪模式：先只在上一帧直线附近的行带内搜索，未命中再回退到整个ROI（可叠加粗到细搜索）
+    static LaserScanOutcome runLaserDetection(const cv::Mat& roiView, const ROI& roi, const LaserDetectionOptions& options,
+                                              LaserTrackingState* tracking, LaserLineAccumulator& acc)
+    {
+        LaserScanOutcome outcome;
+        bool trackingActive = options.trackingEnabled && tracking != nullptr;
+        // 空帧快速拒绝：稀疏抽样无激光证据时直接返回，不读取其余像素
+        if (options.prescanEnabled && !prescanLaserEvidence(roiView, options))
+        {
+            logOf(options).info("预扫描未发现激光（行步长 {}，列步长 {}），跳过完整检测", options.prescanRowStep, options.prescanColStep);
+            outcome.status = DetectionResultCode::NOT_FOUND;
+            outcome.pointCount = 0;
+            outcome.threshold = options.threshold;
+            outcome.prescanRejected = true;
+            outcome.fit = LaserLineFit();
+            if (trackingActive)
+                updateTrackingState(*tracking, roi, outcome);
+            return outcome;
+        }
+        // Otsu 阈值依赖整个ROI的背景分布，只扫描行带会改变阈值，因此该模式下始终扫描整个ROI（跟踪状态照常更新）
+        const bool narrowRows = options.thresholdMode != LaserThresholdMode::OTSU;
+        bool tracked = false;
+        if (narrowRows && trackingActive && tracking->valid &&
+            tracking->roiX == roi.x && tracking->roiY == roi.y &&
+            tracking->roiWidth == roi.width && tracking->roiHeight == roi.height)
+        {
+            int half = std::max(options.trackingBandHeight, 2) / 2;
+            int bandBegin = std::max(0, tracking->lineTop - half);
+            int bandEnd = std::min(roiView.rows, tracking->lineBottom + half + 1);
+            outcome = scanAndFit(roiView, roi, options, bandBegin, bandEnd, acc);
+            tracked = (outcome.status == DetectionResultCode::SUCCESS);
+            if (tracked)
+                logOf(options).info("跟踪带内检测成功: 行 {} - {}", bandBegin, bandEnd);
+            else
+                logOf(options).info("跟踪带内未检测到激光线（行 {} - {}），回退到整个ROI", bandBegin, bandEnd);
+        }
+        if (!tracked)
+        {
+            // 粗到细：先在抽样网格上定位激光带，只对带内行做全分辨率扫描；粗搜索无命中时扫描整个ROI
+            int rowBegin = 0, rowEnd = roiView.rows;
+            if (narrowRows && options.pyramidFactor > 1)
+            {
+                if (locateLaserBand(roiView, options, rowBegin, rowEnd))
+                    logOf(options).info("粗搜索定位激光带: 行 {} - {}", rowBegin, rowEnd);
+                else
+                    logOf(options).info("粗搜索未命中，扫描整个ROI");
+            }
+            outcome = scanAndFit(roiView, roi, options, rowBegin, rowEnd, acc);
+        }
+        if (trackingActive)
+            updateTrackingState(*tracking, roi, outcome);
+        return outcome;
+    }
+
+    // 检测并写入飞行记录（只复制原始ROI像素，不编码）；未配置记录仪时与 runLaserDetection 相同。
+    // rawView/rawPattern 为原图上的ROI与其Bayer排列：roiView 是共享强度平面时，记录的仍是原始像素，转存可按单ROI方式复现
+    static LaserScanOutcome runRecordedDetection(const cv::Mat& roiView, const ROI& roi, int roiIndex, const LaserDetectionOptions& options,
+                                                 LaserTrackingState* tracking, LaserLineAccumulator& acc,
+                                                 const cv::Mat& rawView, LaserBayerPattern rawPattern)
+    {
+        if (options.flightRecorder == nullptr)
+            return runLaserDetection(roiView, roi, options, tracking, acc);
+
+        auto start = std::chrono::steady_clock::now();
+        LaserScanOutcome outcome = runLaserDetection(roiView, roi, options, tracking, acc);
+        FlightRecord meta;
+        meta.roiIndex = roiIndex;
+        meta.roiX = roi.x;
+        meta.roiY = roi.y;
+        meta.roiWidth = roi.width;
+        meta.roiHeight = roi.height;
+        meta.bayerPattern = bayerPatternAt(rawPattern, roi.x, roi.y);
+        meta.status = static_cast<int>(outcome.status);
+        meta.threshold = outcome.threshold;
+        meta.pointCount = static_cast<int>(outcome.pointCount);
+        if (outcome.status != DetectionResultCode::NOT_FOUND)
+            meta.inliers = outcome.fit.inliers;
+        if (outcome.status == DetectionResultCode::SUCCESS)
+            meta.lineAngle = std::atan2(outcome.fit.line[1], outcome.fit.line[0]);
+        meta.scanUs = static_cast<int>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+        options.flightRecorder->record(rawView, meta);
+        return outcome;
+    }
+
+    // 检测失败时把飞行记录的最近窗口转存到输出目录，两次转存之间至少间隔一个窗口的新记录
+    static void dumpFlightOnFailure(const LaserDetectionOptions& options, const std::string& outputDir, const std::string& sn)
+    {
+        if (options.flightRecorder == nullptr || options.flightDumpWindow <= 0 || outputDir.empty())
+            return;
+        std::string dumpPath = generateFileName(outputDir + "/flight", sn, ".llfr");
+        if (options.flightRecorder->dump(dumpPath, options.flightDumpWindow, options.flightDumpWindow) > 0 && options.retention != nullptr)
+            options.retention->track(dumpPath, true);
     }
 
     // 激光线检测核心函数
     LidarDetectionResult detectLidarLine(const cv::Mat& image, const ROI& roi, const std::string& sn, const std::string& outputDir)
     {
-        logger->info("开始激光线检测，ROI: x={}, y={}, w={}, h={}", roi.x, roi.y, roi.width, roi.height);
+        return detectLidarLine(image, roi, sn, outputDir, LaserDetectionOptions());
+    }
+
+    LidarDetectionResult detectLidarLine(const cv::Mat& image, const ROI& roi, const std::string& sn, const std::string& outputDir, const LaserDetectionOptions& options, LaserTrackingState* tracking)
+    {
+        logOf(options).info("开始激光线检测，ROI: x={}, y={}, w={}, h={}", roi.x, roi.y, roi.width, roi.height);
         LidarDetectionResult result;
         result.status = DetectionResultCode::NOT_FOUND;
         result.line_angle = 0.0f;
         result.image_path = "";
+        result.inlier_count = 0;
+        result.fit_iterations = 0;
+        result.threshold = options.threshold;
+        result.image_save_failed = false;
+
+        if (!isSupportedLaserImageType(image.type()))
+        {
+            logOf(options).error("不支持的图像格式: type={}", image.type());
+            result.status = DetectionResultCode::IMAGE_LOAD_FAILED;
+            return result;
+        }
 
         // 检查ROI是否在图像范围内
         cv::Rect roiRect(roi.x, roi.y, roi.width, roi.height);
@@ -123,182 +536,112 @@ namespace LidarLineDetector {
             roiRect.x + roiRect.width > image.cols ||
             roiRect.y + roiRect.height > image.rows)
         {
-            logger->warn("ROI超出图像范围");
+            logOf(options).warn("ROI超出图像范围");
             result.status = DetectionResultCode::OUT_OF_ROI;
             // 保存失败图像
-            if (!outputDir.empty())
-            {
-                cv::Mat resultImage = image.clone();
-                cv::rectangle(resultImage, cv::Rect(roi.x, roi.y, roi.width, roi.height), cv::Scalar(0, 0, 255), 2);
-                cv::putText(resultImage, "ROI Out of Range", cv::Point(20, 30), cv::FONT_HERSHEY_SIMPLEX, 0.7, cv::Scalar(0, 0, 255), 2);
-                std::string fileName = generateFileName(outputDir + "/result", sn);
-                if (cv::imwrite(fileName, resultImage))
-                {
-                    logger->info("失败结果图像已保存: {}", fileName);
-                    result.image_path = fileName;
-                }
-            }
+            result.image_path = saveDetectionImage(image, roiRect, options, outputDir, sn, "ROI Out of Range");
             return result;
         }
-        // 提取ROI区域
-        cv::Mat roiMat = image(roiRect).clone();
-        if (roiMat.empty())
+        // 提取ROI区域（仅为视图，不复制像素）
+        cv::Mat roiView = image(roiRect);
+        if (roiView.empty())
         {
-            logger->error("提取ROI区域失败");
+            logOf(options).error("提取ROI区域失败");
             result.status = DetectionResultCode::OUT_OF_ROI;
             // 保存失败图像
-            if (!outputDir.empty())
-            {
-                cv::Mat resultImage = image.clone();
-                cv::rectangle(resultImage, cv::Rect(roi.x, roi.y, roi.width, roi.height), cv::Scalar(0, 0, 255), 2);
-                cv::putText(resultImage, "ROI Extraction Failed", cv::Point(20, 30), cv::FONT_HERSHEY_SIMPLEX, 0.7, cv::Scalar(0, 0, 255), 2);
-                std::string fileName = generateFileName(outputDir + "/result", sn);
-                if (cv::imwrite(fileName, resultImage))
-                {
-                    logger->info("失败结果图像已保存: {}", fileName);
-                    result.image_path = fileName;
-                }
-            }
+            result.image_path = saveDetectionImage(image, roiRect, options, outputDir, sn, "ROI Extraction Failed");
             return result;
         }
-        // 灰度化
-        cv::Mat gray;
-        cv::cvtColor(roiMat, gray, cv::COLOR_BGR2GRAY);
-
-        // 提取所有高亮点
-        std::vector<cv::Point> laserPoints;
-        for (int y = 0; y < gray.rows; ++y) {
-            for (int x = 0; x < gray.cols; ++x) {
-                if (gray.at<uchar>(y, x) > 220) { // 阈值可调
-                    laserPoints.emplace_back(x, y);
-                }
-            }
-        }
+        // 会话缓冲区中的累加器跨帧复用，容量在预热（或预分配）后不再增长
+        LaserLineAccumulator localAcc;
+        LaserLineAccumulator& acc = options.scratch != nullptr && !options.scratch->accumulators.empty()
+                                        ? options.scratch->accumulators.front() : localAcc;
+        LaserScanOutcome outcome = runRecordedDetection(roiView, roi, 0, options, tracking, acc, roiView, options.bayerPattern);
+        if (outcome.status != DetectionResultCode::SUCCESS)
+            dumpFlightOnFailure(options, outputDir, sn);
 
-        // 可视化激光点
-        cv::Mat debugPoints = roiMat.clone();
-        for (const auto& pt : laserPoints) {
-            cv::circle(debugPoints, pt, 1, cv::Scalar(0, 0, 255), -1);
-        }
-        if (!outputDir.empty()) {
-            std::string debugFileName = generateFileName(outputDir + "/debug_laser_points", sn);
-            cv::imwrite(debugFileName, debugPoints);
+        const size_t pointCount = outcome.pointCount;
+        const LaserLineFit& fit = outcome.fit;
+        result.threshold = outcome.threshold;
+        if (options.thresholdMode != LaserThresholdMode::FIXED)
+            logOf(options).info("自适应阈值: {}", outcome.threshold);
+
+        // 预扫描判定为空帧：失败结果图按配置决定是否保存
+        if (outcome.prescanRejected)
+        {
+            result.status = DetectionResultCode::NOT_FOUND;
+            if (options.prescanSaveImage)
+                result.image_path = saveDetectionImage(image, roiRect, options, outputDir, sn, "No Laser (Prescan)");
+            return result;
         }
 
+        // 结果图上的激光点与直线（仅在按策略需要保存时绘制）
+        auto drawPoints = [&](cv::Mat& canvas, const cv::Point& roiOrigin) {
+            drawLaserPoints(canvas, roiOrigin, roiView, options, outcome.threshold, acc);
+        };
+
         // 判据1：点数
-        if (laserPoints.size() < 10)
+        if (outcome.status == DetectionResultCode::NOT_FOUND)
         {
-            logger->warn("激光点太少，检测失败，点数: {}", laserPoints.size());
+            logOf(options).warn("激光点太少，检测失败，点数: {}", pointCount);
             result.status = DetectionResultCode::NOT_FOUND;
             // 保存失败图像
-            if (!outputDir.empty())
-            {
-                cv::Mat resultImage = image.clone();
-                cv::rectangle(resultImage, cv::Rect(roi.x, roi.y, roi.width, roi.height), cv::Scalar(0, 0, 255), 2);
-                cv::putText(resultImage, "Insufficient Laser Points: " + std::to_string(laserPoints.size()), cv::Point(20, 30), cv::FONT_HERSHEY_SIMPLEX, 0.7, cv::Scalar(0, 0, 255), 2);
-                std::string fileName = generateFileName(outputDir + "/result", sn);
-                if (cv::imwrite(fileName, resultImage))
-                {
-                    logger->info("失败结果图像已保存: {}", fileName);
-                    result.image_path = fileName;
-                }
-            }
+            result.image_path = saveDetectionImage(image, roiRect, options, outputDir, sn, true,
+                                                   [&] { return "Insufficient Laser Points: " + std::to_string(pointCount); }, drawPoints);
             return result;
         }
-        // 用fitLine拟合直线
-        cv::Vec4f line;
-        cv::fitLine(laserPoints, line, cv::DIST_L2, 0, 0.01, 0.01);
-        float vx = line[0], vy = line[1], x0 = line[2], y0 = line[3];
-
-        // 判据2：RMS误差
-        double sumDist2 = 0;
-        for (const auto& pt : laserPoints) {
-            double dist = std::abs(vy * (pt.x - x0) - vx * (pt.y - y0)) / std::sqrt(vx * vx + vy * vy);
-            sumDist2 += dist * dist;
-        }
-        double rms = std::sqrt(sumDist2 / laserPoints.size());
+        result.inlier_count = fit.inliers;
+        result.fit_iterations = fit.iterations;
+        const cv::Vec4f& line = fit.line;
 
-        // 判据3：投影长度
-        std::vector<double> projections;
-        for (const auto& pt : laserPoints) {
-            double proj = (pt.x - x0) * vx + (pt.y - y0) * vy;
-            projections.push_back(proj);
-        }
-        auto minmax = std::minmax_element(projections.begin(), projections.end());
-        double length = *minmax.second - *minmax.first;
-        logger->warn("激光点分布不线性或长度不足，RMS: {}, 长度: {}", rms, length);
+        // 判据2：RMS误差；判据3：投影长度（均来自同一组矩与每行端点）
+        double rms = fit.rms;
+        double length = fit.maxProj - fit.minProj;
+        logOf(options).info("直线拟合完成，RMS: {}, 长度: {}, 内点: {}, 迭代: {}", rms, length, fit.inliers, fit.iterations);
 
         // 阈值可根据实际调整
-        if (rms > 5.0 || length < roi.width * 0.5) {
-            logger->warn("激光点分布不线性或长度不足，RMS: {}, 长度: {}", rms, length);
+        if (outcome.status == DetectionResultCode::OUT_OF_ROI) {
+            logOf(options).warn("激光点分布不线性或长度不足，RMS: {}, 长度: {}", rms, length);
             result.status = DetectionResultCode::OUT_OF_ROI;
             // 保存失败图像
-            if (!outputDir.empty()) {
-                cv::Mat resultImage = image.clone();
-                cv::rectangle(resultImage, cv::Rect(roi.x, roi.y, roi.width, roi.height), cv::Scalar(0, 0, 255), 2);
-                std::string reason = (rms > 3.0) ? ("RMS: " + std::to_string(rms)) : ("Length: " + std::to_string(length));
-                cv::putText(resultImage, "No Laser Line: " + reason, cv::Point(20, 30), cv::FONT_HERSHEY_SIMPLEX, 0.7, cv::Scalar(0, 0, 255), 2);
-                std::string fileName = generateFileName(outputDir + "/result", sn);
-                if (cv::imwrite(fileName, resultImage))
-                {
-                    logger->info("失败结果图像已保存: {}", fileName);
-                    result.image_path = fileName;
-                }
-            }
+            result.image_path = saveDetectionImage(image, roiRect, options, outputDir, sn, true, [&] {
+                return "No Laser Line: " + ((rms > 3.0) ? ("RMS: " + std::to_string(rms)) : ("Length: " + std::to_string(length)));
+            }, drawPoints);
             return result;
         }
 
         float lineAngle = std::atan2(line[1], line[0]);
         result.status = DetectionResultCode::SUCCESS;
         result.line_angle = lineAngle;
-        logger->info("激光线检测成功，角度: {:.2f}°，点数: {}, RMS: {:.2f}, 长度: {:.2f}", lineAngle * 180.0 / CV_PI, laserPoints.size(), rms, length);
-        // 如果输出目录不为空，保存结果图像
-        if (!outputDir.empty())
-        {
-            cv::Mat resultImage = image.clone();
-            // 画ROI和直线段（只覆盖所有高亮点）
-            // 计算所有点在直线方向上的投影
-            std::vector<double> projections;
-            for (const auto& pt : laserPoints) {
-                double proj = (pt.x - x0) * vx + (pt.y - y0) * vy;
-                projections.push_back(proj);
-            }
-            auto minmax = std::minmax_element(projections.begin(), projections.end());
-            double minProj = *minmax.first;
-            double maxProj = *minmax.second;
-            // 计算直线段的两个端点（ROI内坐标）
-            cv::Point pt1_roi(x0 + minProj * vx, y0 + minProj * vy);
-            cv::Point pt2_roi(x0 + maxProj * vx, y0 + maxProj * vy);
-            // 转为全图坐标
-            cv::Point pt1(pt1_roi.x + roi.x, pt1_roi.y + roi.y);
-            cv::Point pt2(pt2_roi.x + roi.x, pt2_roi.y + roi.y);
-            cv::rectangle(resultImage, cv::Rect(roi.x, roi.y, roi.width, roi.height), cv::Scalar(0, 255, 0), 2);
-            cv::line(resultImage, pt1, pt2, cv::Scalar(0, 0, 255), 2, cv::LINE_AA);
-            std::string fileName = generateFileName(outputDir + "/result", sn);
-            if (cv::imwrite(fileName, resultImage))
-            {
-                logger->info("检测结果图像已保存: {}", fileName);
-                result.image_path = fileName;
-            }
-            else
-            
-            {
-                logger->error("保存图像失败: {}", fileName);
-            }
-        }
+        logOf(options).info("激光线检测成功，角度: {:.2f}°，点数: {}, RMS: {:.2f}, 长度: {:.2f}", lineAngle * 180.0 / CV_PI, pointCount, rms, length);
+        // 按策略保存结果图：ROI、激光点和直线段（只覆盖所有高亮点，端点取投影范围）
+        result.image_path = saveDetectionImage(image, roiRect, options, outputDir, sn, false, [] { return std::string(); },
+                                               [&](cv::Mat& canvas, const cv::Point& roiOrigin) {
+            drawPoints(canvas, roiOrigin);
+            drawLaserSegment(canvas, fit, roiOrigin);
+        }, &result.image_save_failed);
         return result;
     }
 
     // 激光线检测主函数
     LidarLineResult detect(const cv::Mat &image, const ROI &roi, const std::string &sn, const std::string &outputDir)
     {
-        logger->info("开始主检测流程");
-        LidarLineResult result{false, 0, "", DetectionResultCode::SUCCESS};
-        LidarDetectionResult detectionResult = detectLidarLine(image, roi, sn, outputDir);
+        return detect(image, roi, sn, outputDir, LaserDetectionOptions());
+    }
+
+    LidarLineResult detect(const cv::Mat &image, const ROI &roi, const std::string &sn, const std::string &outputDir, const LaserDetectionOptions &options, LaserTrackingState *tracking)
+    {
+        logOf(options).info("开始主检测流程");
+        LidarLineResult result{false, 0, "", DetectionResultCode::SUCCESS, 0, 0, 0};
+        LidarDetectionResult detectionResult = detectLidarLine(image, roi, sn, outputDir, options, tracking);
+        result.image_path = detectionResult.image_path; // 结果图由 detectLidarLine 按策略保存，此处不再重复编码
+        result.inlier_count = detectionResult.inlier_count;
+        result.fit_iterations = detectionResult.fit_iterations;
+        result.threshold = detectionResult.threshold;
 
         if (detectionResult.status != DetectionResultCode::SUCCESS)
         {
-            logger->warn("主检测流程：激光线检测失败，状态: {}", static_cast<int>(detectionResult.status));
+            logOf(options).warn("主检测流程：激光线检测失败，状态: {}", static_cast<int>(detectionResult.status));
             switch (detectionResult.status) {
                 case DetectionResultCode::NOT_FOUND:
                     result.error_code = DetectionResultCode::NOT_FOUND;
@@ -313,78 +656,537 @@ namespace LidarLineDetector {
             return result;
         }
         result.line_angle = detectionResult.line_angle;
-        logger->info("主检测流程：激光线检测成功，角度: {:.2f}°", result.line_angle * 180.0 / CV_PI);
+        logOf(options).info("主检测流程：激光线检测成功，角度: {:.2f}°", result.line_angle * 180.0 / CV_PI);
+        // 线已检出但同步写盘失败（异步写盘时失败只计入输出队列统计）
+        if (detectionResult.image_save_failed)
+            result.error_code = DetectionResultCode::IMAGE_SAVE_FAILED;
 
-        // 如果输出目录不为空，保存结果图像
-        if (!outputDir.empty())
+        result.line_detected = true;
+        return result;
+    }
+
+    // 多ROI/多激光线检测：各ROI并行检测，彩色图像中重叠的ROI共享一次强度换算，只保存一张汇总结果图
+    std::vector<LidarDetectionResult> detectLidarLines(const cv::Mat &image, const std::vector<ROI> &rois, const std::string &sn, const std::string &outputDir, const LaserDetectionOptions &options,
+                                                       std::vector<LaserTrackingState> *tracking)
+    {
+        logOf(options).info("开始多ROI激光线检测，ROI数: {}", rois.size());
+        const int count = static_cast<int>(rois.size());
+        std::vector<LidarDetectionResult> results(count);
+        for (LidarDetectionResult &r : results)
+        {
+            r.status = DetectionResultCode::NOT_FOUND;
+            r.line_angle = 0.0f;
+            r.image_path = "";
+            r.inlier_count = 0;
+            r.fit_iterations = 0;
+            r.threshold = options.threshold;
+            r.image_save_failed = false;
+        }
+        if (!isSupportedLaserImageType(image.type()))
+        {
+            logOf(options).error("不支持的图像格式: type={}", image.type());
+            for (LidarDetectionResult &r : results)
+                r.status = DetectionResultCode::IMAGE_LOAD_FAILED;
+            return results;
+        }
+
+        // 校验各ROI，并判断合法ROI之间是否重叠
+        const cv::Rect imageRect(0, 0, image.cols, image.rows);
+        std::vector<cv::Rect> rects(count);
+        std::vector<char> valid(count, 0);
+        cv::Rect unionRect;
+        bool overlap = false;
+        for (int i = 0; i < count; ++i)
         {
-            cv::Mat resultImage = image.clone();
-            if (resultImage.empty())
+            rects[i] = cv::Rect(rois[i].x, rois[i].y, rois[i].width, rois[i].height);
+            valid[i] = rois[i].width > 0 && rois[i].height > 0 && (rects[i] & imageRect) == rects[i];
+            if (!valid[i])
             {
-                logger->error("克隆图像失败");
-                result.error_code = DetectionResultCode::IMAGE_SAVE_FAILED;
-                return result;
+                logOf(options).warn("ROI[{}]超出图像范围", i);
+                results[i].status = DetectionResultCode::OUT_OF_ROI;
+                continue;
             }
+            for (int j = 0; j < i; ++j)
+                overlap = overlap || (valid[j] && (rects[i] & rects[j]).area() > 0);
+            unionRect = unionRect.empty() ? rects[i] : (unionRect | rects[i]);
+        }
 
-            // line: [vx, vy, x, y]，x/y是ROI内坐标
-            float vx = detectionResult.line_angle; // 使用检测到的角度作为vx
-            float x = 0; // 假设直线在ROI的左端点
-            float y = 0; // 假设直线在ROI的左端点
-
-            // 计算直线在ROI内的两个端点（以ROI内坐标为基准）
-            float leftY = (-x * vx / 1) + y;                   // x=0
-            float rightY = ((roi.width - 1 - x) * vx / 1) + y; // x=roi.width-1
-
-            cv::Point pt1(roi.x, roi.y + cvRound(leftY));
-            cv::Point pt2(roi.x + roi.width - 1, roi.y + cvRound(rightY));
-            cv::rectangle(resultImage, cv::Rect(roi.x, roi.y, roi.width, roi.height), cv::Scalar(0, 255, 0), 2);
-            cv::line(resultImage, pt1, pt2, cv::Scalar(0, 0, 255), 2, cv::LINE_AA);
+        // 共享强度平面与各ROI累加器优先使用会话缓冲区（尺寸不变时不再分配）
+        cv::Mat localIntensity;
+        cv::Mat& sharedIntensity = options.scratch != nullptr ? options.scratch->intensity : localIntensity;
+        std::vector<LaserLineAccumulator> localAccs;
+        std::vector<LaserLineAccumulator>& accs = options.scratch != nullptr ? options.scratch->accumulators : localAccs;
+        if (accs.size() < static_cast<size_t>(count))
+            accs.resize(count);
+        // 跟踪状态记录了对应的ROI，ROI变化时自动失效，因此按下标复用即可
+        if (tracking != nullptr && tracking->size() < static_cast<size_t>(count))
+            tracking->resize(count);
+        bool shared = false;
+        // 共享强度平面已是8位单通道，各ROI按 MONO8 处理
+        LaserDetectionOptions roiOptions = options;
+        if (overlap && resolveLaserPixelFormat(image.type(), options.bayerPattern) != LaserPixelFormat::MONO8)
+        {
+            computeLaserIntensity(image(unionRect), options, sharedIntensity);
+            shared = true;
+            roiOptions.bayerPattern = LaserBayerPattern::NONE;
+            logOf(options).info("ROI存在重叠，并集区域共享一次强度换算: x={}, y={}, w={}, h={}", unionRect.x, unionRect.y, unionRect.width, unionRect.height);
+        }
 
-            // 生成文件名并保存图像
-            std::string fileName = generateFileName(outputDir + "/result", sn);
-            if (!cv::imwrite(fileName, resultImage))
+        std::vector<LaserScanOutcome> outcomes(count);
+        cv::parallel_for_(cv::Range(0, count), [&](const cv::Range &range) {
+            for (int i = range.start; i < range.end; ++i)
             {
-                logger->error("保存图像失败: {}", fileName);
-                result.error_code = DetectionResultCode::IMAGE_SAVE_FAILED;
+                if (!valid[i])
+                    continue;
+                cv::Mat roiView = !shared
+                                      ? image(rects[i])
+                                      : sharedIntensity(cv::Rect(rects[i].x - unionRect.x, rects[i].y - unionRect.y, rects[i].width, rects[i].height));
+                outcomes[i] = runRecordedDetection(roiView, rois[i], i, roiOptions, tracking != nullptr ? &(*tracking)[i] : nullptr, accs[i],
+                                                   image(rects[i]), options.bayerPattern);
+                LidarDetectionResult &r = results[i];
+                r.status = outcomes[i].status;
+                r.threshold = outcomes[i].threshold;
+                if (outcomes[i].status != DetectionResultCode::NOT_FOUND)
+                {
+                    r.inlier_count = outcomes[i].fit.inliers;
+                    r.fit_iterations = outcomes[i].fit.iterations;
+                }
+                if (r.status == DetectionResultCode::SUCCESS)
+                    r.line_angle = std::atan2(outcomes[i].fit.line[1], outcomes[i].fit.line[0]);
+                logOf(options).info("ROI[{}]检测完成，状态: {}，点数: {}", i, static_cast<int>(r.status), outcomes[i].pointCount);
             }
-            else
+        });
+
+        // 所有ROI绘制在同一张结果图上，只编码保存一次；任一ROI失败即按失败帧计入保存策略
+        bool anyFailed = false;
+        cv::Rect focus;
+        for (int i = 0; i < count; ++i)
+        {
+            anyFailed = anyFailed || results[i].status != DetectionResultCode::SUCCESS;
+            cv::Rect clipped = rects[i] & imageRect;
+            if (!clipped.empty())
+                focus = focus.empty() ? clipped : (focus | clipped);
+        }
+        if (anyFailed)
+            dumpFlightOnFailure(options, outputDir, sn);
+        if (!outputDir.empty() && count > 0 && wantArtifact(options, anyFailed))
+        {
+            bool saveFailed = false;
+            std::string fileName = saveOverlay(image, focus.empty() ? imageRect : focus, options, outputDir, sn, anyFailed, [&](cv::Mat& canvas, const cv::Point& origin) {
+                for (int i = 0; i < count; ++i)
+                {
+                    bool ok = results[i].status == DetectionResultCode::SUCCESS;
+                    cv::Scalar color = ok ? cv::Scalar(0, 255, 0) : cv::Scalar(0, 0, 255);
+                    cv::rectangle(canvas, (rects[i] & imageRect) - origin, color, 2);
+                    if (ok)
+                        drawLaserSegment(canvas, outcomes[i].fit, rects[i].tl() - origin);
+                    else
+                        cv::putText(canvas, "ROI " + std::to_string(i) + " Failed: " + std::to_string(static_cast<int>(results[i].status)),
+                                    cv::Point(20, 30 + 30 * i), cv::FONT_HERSHEY_SIMPLEX, 0.7, cv::Scalar(0, 0, 255), 2);
+                }
+            }, &saveFailed);
+            for (LidarDetectionResult &r : results)
             {
-                logger->info("检测结果图像已保存: {}", fileName);
-                result.image_path = fileName;
+                r.image_path = fileName;
+                r.image_save_failed = saveFailed;
             }
         }
-
-        result.line_detected = true;
-        return result;
+        return results;
     }
 
-
-
 } // namespace LidarLineDetector
 
 // 封装类实现
 DetectionResultCode CLidarLineDetector::initialize(const char *configPath)
 {
-    return LidarLineDetector::readROIFromConfig(configPath, m_roi);
+    DetectionResultCode code = LidarLineDetector::readROIsFromConfig(configPath, m_rois);
+    if (code == DetectionResultCode::SUCCESS)
+        m_roi = m_rois.front();
+    m_tracking.valid = false;
+    m_multiTracking.clear();
+    reserveScratch();
+    return code;
 }
 
-void CLidarLineDetector::setROI(int x, int y, int width, int height) { m_roi = {x, y, width, height}; }
+void CLidarLineDetector::setROI(int x, int y, int width, int height)
+{
+    m_roi = {x, y, width, height};
+    m_rois.assign(1, m_roi);
+    m_tracking.valid = false;
+    m_multiTracking.clear();
+    reserveScratch();
+}
+
+// 按当前全部ROI与检测参数预留会话缓冲；容量只增不减，参数来回切换不会反复分配
+void CLidarLineDetector::reserveScratch()
+{
+    if (!m_scratch)
+        m_scratch.reset(new LidarLineDetector::LaserScratchArena());
+    m_scratch->reserve(m_rois, m_options);
+    m_options.scratch = m_scratch.get();
+}
 void CLidarLineDetector::setSn(const char *sn) { m_sn = sn ? sn : ""; }
+
+void CLidarLineDetector::setCameraId(const char *cameraId)
+{
+    m_cameraId = cameraId ? cameraId : "";
+    m_logger = m_cameraId.empty() ? nullptr : LidarLineDetector::cameraLogger(m_cameraId);
+    m_options.logger = m_logger.get();
+}
 void CLidarLineDetector::setOutputDir(const char *outputDir) { m_outputDir = outputDir ? outputDir : ""; }
 
+void CLidarLineDetector::setIntensityChannel(int channel)
+{
+    if (channel < static_cast<int>(LidarLineDetector::IntensityChannel::LUMINANCE) ||
+        channel > static_cast<int>(LidarLineDetector::IntensityChannel::RED))
+        channel = static_cast<int>(LidarLineDetector::IntensityChannel::LUMINANCE);
+    m_options.channel = static_cast<LidarLineDetector::IntensityChannel>(channel);
+}
+
+void CLidarLineDetector::setLaserThreshold(int threshold)
+{
+    m_options.threshold = static_cast<uchar>(std::min(std::max(threshold, 0), 254));
+}
+
+void CLidarLineDetector::setExtractionMode(int mode)
+{
+    if (mode < static_cast<int>(LidarLineDetector::LaserExtractionMode::THRESHOLD) ||
+        mode > static_cast<int>(LidarLineDetector::LaserExtractionMode::COLUMN_PEAK))
+        mode = static_cast<int>(LidarLineDetector::LaserExtractionMode::THRESHOLD);
+    m_options.extractionMode = static_cast<LidarLineDetector::LaserExtractionMode>(mode);
+}
+
+// Otsu 模式始终扫描整个ROI：与跟踪/粗到细同时开启时提示行范围收窄不生效
+static void warnUnnarrowedOtsu(const LidarLineDetector::LaserDetectionOptions &options)
+{
+    if (options.thresholdMode == LidarLineDetector::LaserThresholdMode::OTSU && (options.trackingEnabled || options.pyramidFactor > 1))
+        LidarLineDetector::logOf(options).warn("Otsu 自适应阈值需要整个ROI的直方图，跟踪与粗到细搜索不收窄扫描行范围");
+}
+
+void CLidarLineDetector::setPyramidSearch(int factor, int margin)
+{
+    m_options.pyramidFactor = (factor == 2 || factor == 4) ? factor : 1;
+    m_options.pyramidMargin = std::max(margin, 0);
+    warnUnnarrowedOtsu(m_options);
+}
+
+void CLidarLineDetector::setTracking(bool enabled, int bandHeight)
+{
+    m_options.trackingEnabled = enabled;
+    if (bandHeight > 0)
+        m_options.trackingBandHeight = bandHeight;
+    m_tracking.valid = false;
+    m_multiTracking.clear();
+    warnUnnarrowedOtsu(m_options);
+}
+
+void CLidarLineDetector::setPrescan(bool enabled, int rowStep, int colStep, int minHits, bool saveImage)
+{
+    m_options.prescanEnabled = enabled;
+    if (rowStep > 0)
+        m_options.prescanRowStep = rowStep;
+    if (colStep > 0)
+        m_options.prescanColStep = colStep;
+    if (minHits > 0)
+        m_options.prescanMinHits = minHits;
+    m_options.prescanSaveImage = saveImage;
+}
+
+void CLidarLineDetector::setPixelFormat(int bayerPattern, int mono16Shift)
+{
+    if (bayerPattern < static_cast<int>(LidarLineDetector::LaserBayerPattern::NONE) ||
+        bayerPattern > static_cast<int>(LidarLineDetector::LaserBayerPattern::GBRG))
+        bayerPattern = static_cast<int>(LidarLineDetector::LaserBayerPattern::NONE);
+    m_options.bayerPattern = static_cast<LidarLineDetector::LaserBayerPattern>(bayerPattern);
+    if (mono16Shift >= 0 && mono16Shift <= 15)
+        m_options.mono16Shift = mono16Shift;
+}
+
+void CLidarLineDetector::setThreadCount(int threads)
+{
+    if (threads <= 0)
+    {
+        m_options.workerPool = nullptr;
+        m_workers.reset();
+        return;
+    }
+    m_workers.reset(new LidarLineDetector::LaserWorkerPool(threads));
+    m_options.workerPool = m_workers.get();
+    reserveScratch();
+}
+
+void CLidarLineDetector::setAdaptiveThreshold(int mode, float percentile, int minThreshold)
+{
+    if (mode < static_cast<int>(LidarLineDetector::LaserThresholdMode::FIXED) ||
+        mode > static_cast<int>(LidarLineDetector::LaserThresholdMode::OTSU))
+        mode = static_cast<int>(LidarLineDetector::LaserThresholdMode::FIXED);
+    m_options.thresholdMode = static_cast<LidarLineDetector::LaserThresholdMode>(mode);
+    if (percentile > 0 && percentile < 100)
+        m_options.adaptivePercentile = percentile;
+    if (minThreshold >= 0)
+        m_options.adaptiveMinThreshold = static_cast<uchar>(std::min(minThreshold, 254));
+    reserveScratch();
+    warnUnnarrowedOtsu(m_options);
+}
+
+void CLidarLineDetector::setRobustFit(int mode, int maxIterations, int timeBudgetUs, float inlierDistance, float targetInlierRatio)
+{
+    m_options.fitMode = (mode == static_cast<int>(LidarLineDetector::LaserFitMode::RANSAC))
+                            ? LidarLineDetector::LaserFitMode::RANSAC
+                            : LidarLineDetector::LaserFitMode::LEAST_SQUARES;
+    if (maxIterations > 0)
+        m_options.ransacMaxIterations = maxIterations;
+    if (timeBudgetUs > 0)
+        m_options.ransacTimeBudgetUs = timeBudgetUs;
+    if (inlierDistance > 0)
+        m_options.ransacInlierDistance = inlierDistance;
+    if (targetInlierRatio > 0 && targetInlierRatio <= 1)
+        m_options.ransacTargetInlierRatio = targetInlierRatio;
+    reserveScratch();
+}
+
 TLidarLineResult_C CLidarLineDetector::detect(const TCMat_C image)
 {
     Mat image_cpp(image.rows, image.cols, image.type, image.data);
-    auto result = LidarLineDetector::detect(image_cpp, m_roi, m_sn, m_outputDir);
+    auto result = LidarLineDetector::detect(image_cpp, m_roi, m_sn, m_outputDir, m_options, &m_tracking);
 
     TLidarLineResult_C result_c;
     result_c.line_detected = result.line_detected;
     result_c.line_angle = result.line_angle;
     snprintf(result_c.image_path, sizeof(result_c.image_path), "%s", result.image_path.c_str());
     result_c.error_code = static_cast<int>(result.error_code);
+    result_c.inlier_count = result.inlier_count;
+    result_c.fit_iterations = result.fit_iterations;
+    result_c.threshold = result.threshold;
     return result_c;
 }
 
+static TLidarLineResult_C toCResult(const LidarDetectionResult &result)
+{
+    TLidarLineResult_C result_c;
+    result_c.line_detected = (result.status == DetectionResultCode::SUCCESS);
+    result_c.line_angle = result.line_angle;
+    snprintf(result_c.image_path, sizeof(result_c.image_path), "%s", result.image_path.c_str());
+    result_c.error_code = static_cast<int>(result.status);
+    result_c.inlier_count = result.inlier_count;
+    result_c.fit_iterations = result.fit_iterations;
+    result_c.threshold = result.threshold;
+    return result_c;
+}
+
+int CLidarLineDetector::detectMulti(const TCMat_C image, const TROIConfig_C *rois, int roiCount, TLidarLineResult_C *results)
+{
+    if (!rois || !results || roiCount <= 0)
+        return 0;
+    std::vector<LidarLineDetector::ROI> roiList(roiCount);
+    for (int i = 0; i < roiCount; ++i)
+        roiList[i] = {rois[i].x, rois[i].y, rois[i].width, rois[i].height};
+
+    Mat image_cpp(image.rows, image.cols, image.type, image.data);
+    auto detections = LidarLineDetector::detectLidarLines(image_cpp, roiList, m_sn, m_outputDir, m_options, &m_multiTracking);
+    for (int i = 0; i < roiCount; ++i)
+        results[i] = toCResult(detections[i]);
+    return roiCount;
+}
+
+int CLidarLineDetector::detectAll(const TCMat_C image, TLidarLineResult_C *results, int maxResults)
+{
+    if (!results || maxResults <= 0)
+        return 0;
+    std::vector<TROIConfig_C> rois;
+    for (const auto &roi : m_rois)
+        rois.push_back({roi.x, roi.y, roi.width, roi.height});
+    int count = std::min(maxResults, static_cast<int>(rois.size()));
+    return detectMulti(image, rois.data(), count, results);
+}
+
+int CLidarLineDetector::getROICount() const
+{
+    return static_cast<int>(m_rois.size());
+}
+
+void CLidarLineDetector::setAsyncOutput(bool enabled, int queueCapacity, int overflowPolicy)
+{
+    // 先等旧队列写完再替换，避免丢失已提交的图像
+    m_options.artifactWriter = nullptr;
+    m_artifacts.reset();
+    if (!enabled)
+        return;
+    auto policy = overflowPolicy == static_cast<int>(LidarLineDetector::ArtifactWriter::OverflowPolicy::BLOCK)
+                      ? LidarLineDetector::ArtifactWriter::OverflowPolicy::BLOCK
+                      : LidarLineDetector::ArtifactWriter::OverflowPolicy::DROP;
+    m_artifacts.reset(new LidarLineDetector::ArtifactWriter(std::max(queueCapacity, 1), policy));
+    m_options.artifactWriter = m_artifacts.get();
+}
+
+bool CLidarLineDetector::flushOutput(int timeoutMs)
+{
+    return !m_artifacts || m_artifacts->flush(timeoutMs);
+}
+
+TArtifactQueueStats_C CLidarLineDetector::getOutputStats() const
+{
+    TArtifactQueueStats_C out = {};
+    if (!m_artifacts)
+        return out;
+    LidarLineDetector::ArtifactWriter::Stats stats = m_artifacts->stats();
+    out.submitted = stats.submitted;
+    out.written = stats.written;
+    out.dropped = stats.dropped;
+    out.failed = stats.failed;
+    out.pending = stats.pending;
+    out.peak_pending = stats.peakPending;
+    return out;
+}
+
+// 飞行记录环形文件关闭后作为失败证据登记，由保留策略按失败图像的保留时间回收
+CLidarLineDetector::~CLidarLineDetector()
+{
+    m_options.flightRecorder = nullptr;
+    m_recorder.reset();
+    if (m_retention && !m_recorderPath.empty()) {
+        m_retention->release(m_recorderPath);
+        m_retention->track(m_recorderPath, true);
+    }
+}
+
+void CLidarLineDetector::setRetention(bool enabled, long long quotaMB, int maxAgeHours, int failureMaxAgeHours)
+{
+    // 各输出组件持有台账指针：先让它们写完并解除引用。台账按根目录在进程内共享，换下的实例可能仍被
+    // 其他检测实例使用，本实例登记的保护必须解除
+    if (m_artifacts)
+        m_artifacts->flush(-1);
+    m_options.retention = nullptr;
+    if (m_video)
+        m_video->setRetention(nullptr);
+    if (m_retention && m_recorder)
+        m_retention->release(m_recorderPath);
+    m_retention.reset();
+    m_logRetention.reset();
+    if (!enabled)
+        return;
+    LidarLineDetector::RetentionManager::Policy policy;
+    policy.quotaBytes = static_cast<uint64_t>(std::max(quotaMB, 0LL)) * 1024 * 1024;
+    policy.maxAgeSeconds = std::max(maxAgeHours, 0) * 3600;
+    policy.failureMaxAgeSeconds = std::max(failureMaxAgeHours, 0) * 3600;
+    // 多相机共用同一输出目录与 log 目录时取得同一实例，最后一次设置的策略生效
+    m_logRetention = LidarLineDetector::RetentionManager::forRoot("log", policy);
+    if (m_outputDir.empty())
+        return;
+    m_retention = LidarLineDetector::RetentionManager::forRoot(m_outputDir, policy);
+    if (m_logRetention == m_retention)
+        m_logRetention.reset(); // 输出目录就是 log 目录，统计不重复计入
+    m_options.retention = m_retention.get();
+    if (m_recorder)
+        m_retention->protect(m_recorderPath);
+    if (m_video)
+        m_video->setRetention(m_retention.get());
+}
+
+TRetentionStats_C CLidarLineDetector::getRetentionStats() const
+{
+    TRetentionStats_C out = {};
+    for (const auto &manager : {m_retention, m_logRetention})
+    {
+        if (!manager)
+            continue;
+        LidarLineDetector::RetentionManager::Stats stats = manager->stats();
+        out.tracked_bytes += stats.trackedBytes;
+        out.tracked_files += stats.trackedFiles;
+        out.reclaimed_bytes += stats.reclaimedBytes;
+        out.reclaimed_files += stats.reclaimedFiles;
+        out.expired_files += stats.expiredFiles;
+        out.quota_evictions += stats.quotaEvictions;
+        out.delete_failures += stats.deleteFailures;
+    }
+    return out;
+}
+
+bool CLidarLineDetector::setVideoOutput(bool enabled, int framesPerSegment, double fps)
+{
+    m_options.videoSink = nullptr;
+    if (m_artifacts)
+        m_artifacts->flush(-1); // 队列中可能还有指向旧会话的帧
+    m_video.reset();
+    if (!enabled)
+        return true;
+    if (m_outputDir.empty())
+        return false;
+    // 会话名沿用结果图的命名规则，索引与分段文件都以它为前缀
+    std::string basePath = LidarLineDetector::generateFileName(m_outputDir + "/session", m_sn, "");
+    m_video.reset(new LidarLineDetector::SessionVideoSink(basePath, framesPerSegment, fps, m_options.artifactPolicy.jpegQuality, m_retention.get()));
+    m_options.videoSink = m_video.get();
+    return true;
+}
+
+bool CLidarLineDetector::setFlightRecorder(const char *path, int slotCount, int slotBytes, int dumpWindow)
+{
+    m_options.flightRecorder = nullptr;
+    m_options.flightDumpWindow = 0;
+    m_recorder.reset();
+    if (m_retention && !m_recorderPath.empty())
+    {
+        m_retention->release(m_recorderPath);
+        m_retention->track(m_recorderPath, true); // 换下的环形文件已关闭，按失败证据回收
+    }
+    m_recorderPath.clear();
+    if (!path || !*path || slotCount <= 0)
+        return true;
+    if (slotBytes <= 0)
+    {
+        // 默认按最大ROI面积、每像素4字节（覆盖BGRA与16位图像）
+        int area = 0;
+        for (const auto &roi : m_rois)
+            area = std::max(area, roi.width * roi.height);
+        slotBytes = area * 4;
+    }
+    std::unique_ptr<LidarLineDetector::FlightRecorder> recorder(new LidarLineDetector::FlightRecorder);
+    if (!recorder->open(path, slotCount, slotBytes))
+        return false;
+    m_recorder = std::move(recorder);
+    m_recorderPath = path;
+    if (m_retention)
+        m_retention->protect(m_recorderPath); // 环形文件一直处于打开状态，不能被当作转存文件回收
+    m_options.flightRecorder = m_recorder.get();
+    m_options.flightDumpWindow = std::max(dumpWindow, 0);
+    return true;
+}
+
+int CLidarLineDetector::dumpFlightRecord(const char *dumpPath, int window)
+{
+    if (!m_recorder || !dumpPath || !*dumpPath)
+        return 0;
+    int written = m_recorder->dump(dumpPath, window);
+    if (written > 0 && m_retention)
+        m_retention->track(dumpPath, true);
+    return written;
+}
+
+void CLidarLineDetector::setArtifactPolicy(int trigger, int sampleEvery, int maxPerMinute, bool cropToROI, float scale, int format, int quality)
+{
+    LidarLineDetector::LaserArtifactPolicy &policy = m_options.artifactPolicy;
+    if (trigger < static_cast<int>(LidarLineDetector::LaserArtifactTrigger::ALWAYS) ||
+        trigger > static_cast<int>(LidarLineDetector::LaserArtifactTrigger::NEVER))
+        trigger = static_cast<int>(LidarLineDetector::LaserArtifactTrigger::ALWAYS);
+    policy.trigger = static_cast<LidarLineDetector::LaserArtifactTrigger>(trigger);
+    policy.sampleEvery = std::max(sampleEvery, 1);
+    policy.maxPerMinute = std::max(maxPerMinute, 0);
+    policy.cropToROI = cropToROI;
+    policy.scale = (scale > 0.0f && scale < 1.0f) ? scale : 1.0f;
+    if (format == static_cast<int>(LidarLineDetector::LaserArtifactFormat::PNG))
+    {
+        policy.format = LidarLineDetector::LaserArtifactFormat::PNG;
+        policy.pngCompression = std::min(std::max(quality, 0), 9);
+    }
+    else
+    {
+        policy.format = LidarLineDetector::LaserArtifactFormat::JPEG;
+        policy.jpegQuality = std::min(std::max(quality, 0), 100);
+    }
+    m_artifactBudget.reset();
+    m_options.artifactBudget = &m_artifactBudget;
+}
+
 
 // 版本信息实现
 VersionInfo CLidarLineDetector::getVersionInfo()
@@ -440,16 +1242,131 @@ extern "C"
         instance->setSn(sn);
     }
 
+    Smpclass_API void CLidarLineDetector_setCameraId(CLidarLineDetector *instance, const char *cameraId)
+    {
+        instance->setCameraId(cameraId);
+    }
+
     Smpclass_API void CLidarLineDetector_setOutputDir(CLidarLineDetector *instance, const char *outputDir)
     {
         instance->setOutputDir(outputDir);
     }
 
+    Smpclass_API void CLidarLineDetector_setIntensityChannel(CLidarLineDetector *instance, int channel)
+    {
+        instance->setIntensityChannel(channel);
+    }
+
+    Smpclass_API void CLidarLineDetector_setLaserThreshold(CLidarLineDetector *instance, int threshold)
+    {
+        instance->setLaserThreshold(threshold);
+    }
+
+    Smpclass_API void CLidarLineDetector_setExtractionMode(CLidarLineDetector *instance, int mode)
+    {
+        instance->setExtractionMode(mode);
+    }
+
+    Smpclass_API void CLidarLineDetector_setPyramidSearch(CLidarLineDetector *instance, int factor, int margin)
+    {
+        instance->setPyramidSearch(factor, margin);
+    }
+
+    Smpclass_API void CLidarLineDetector_setTracking(CLidarLineDetector *instance, int enabled, int bandHeight)
+    {
+        instance->setTracking(enabled != 0, bandHeight);
+    }
+
+    Smpclass_API void CLidarLineDetector_setAsyncOutput(CLidarLineDetector *instance, int enabled, int queueCapacity, int overflowPolicy)
+    {
+        instance->setAsyncOutput(enabled != 0, queueCapacity, overflowPolicy);
+    }
+
+    Smpclass_API int CLidarLineDetector_flushOutput(CLidarLineDetector *instance, int timeoutMs)
+    {
+        return instance->flushOutput(timeoutMs) ? 1 : 0;
+    }
+
+    Smpclass_API TArtifactQueueStats_C CLidarLineDetector_getOutputStats(CLidarLineDetector *instance)
+    {
+        return instance->getOutputStats();
+    }
+
+    Smpclass_API void CLidarLineDetector_setRetention(CLidarLineDetector *instance, int enabled, long long quotaMB, int maxAgeHours, int failureMaxAgeHours)
+    {
+        instance->setRetention(enabled != 0, quotaMB, maxAgeHours, failureMaxAgeHours);
+    }
+
+    Smpclass_API TRetentionStats_C CLidarLineDetector_getRetentionStats(CLidarLineDetector *instance)
+    {
+        return instance->getRetentionStats();
+    }
+
+    Smpclass_API int CLidarLineDetector_setVideoOutput(CLidarLineDetector *instance, int enabled, int framesPerSegment, double fps)
+    {
+        return instance->setVideoOutput(enabled != 0, framesPerSegment, fps) ? 1 : 0;
+    }
+
+    Smpclass_API int CLidarLineDetector_setFlightRecorder(CLidarLineDetector *instance, const char *path, int slotCount, int slotBytes, int dumpWindow)
+    {
+        return instance->setFlightRecorder(path, slotCount, slotBytes, dumpWindow) ? 1 : 0;
+    }
+
+    Smpclass_API int CLidarLineDetector_dumpFlightRecord(CLidarLineDetector *instance, const char *dumpPath, int window)
+    {
+        return instance->dumpFlightRecord(dumpPath, window);
+    }
+
+    Smpclass_API void CLidarLineDetector_setArtifactPolicy(CLidarLineDetector *instance, int trigger, int sampleEvery, int maxPerMinute, int cropToROI, float scale, int format, int quality)
+    {
+        instance->setArtifactPolicy(trigger, sampleEvery, maxPerMinute, cropToROI != 0, scale, format, quality);
+    }
+
+    Smpclass_API void CLidarLineDetector_setPrescan(CLidarLineDetector *instance, int enabled, int rowStep, int colStep, int minHits, int saveImage)
+    {
+        instance->setPrescan(enabled != 0, rowStep, colStep, minHits, saveImage != 0);
+    }
+
+    Smpclass_API void CLidarLineDetector_setPixelFormat(CLidarLineDetector *instance, int bayerPattern, int mono16Shift)
+    {
+        instance->setPixelFormat(bayerPattern, mono16Shift);
+    }
+
+    Smpclass_API void CLidarLineDetector_setThreadCount(CLidarLineDetector *instance, int threads)
+    {
+        instance->setThreadCount(threads);
+    }
+
+    Smpclass_API void CLidarLineDetector_setAdaptiveThreshold(CLidarLineDetector *instance, int mode, float percentile, int minThreshold)
+    {
+        instance->setAdaptiveThreshold(mode, percentile, minThreshold);
+    }
+
+    Smpclass_API void CLidarLineDetector_setRobustFit(CLidarLineDetector *instance, int mode, int maxIterations, int timeBudgetUs, float inlierDistance, float targetInlierRatio)
+    {
+        instance->setRobustFit(mode, maxIterations, timeBudgetUs, inlierDistance, targetInlierRatio);
+    }
+
     Smpclass_API TLidarLineResult_C CLidarLineDetector_detect(CLidarLineDetector *instance, const TCMat_C image)
     {
         return instance->detect(image);
     }
 
+    Smpclass_API int CLidarLineDetector_detectMulti(CLidarLineDetector *instance, const TCMat_C image, const TROIConfig_C *rois, int roiCount, TLidarLineResult_C *results)
+    {
+        return instance->detectMulti(image, rois, roiCount, results);
+    }
+
+    Smpclass_API int CLidarLineDetector_detectAll(CLidarLineDetector *instance, const TCMat_C image, TLidarLineResult_C *results, int maxResults)
+    {
+        return instance->detectAll(image, results, maxResults);
+    }
+
+    Smpclass_API int CLidarLineDetector_getROICount(CLidarLineDetector *instance)
+    {
+        return instance->getROICount();
+    }
+
 
 
     // 版本信息C接口实现
@@ -477,4 +1394,9 @@ extern "C"
     {
         return LidarLineDetector::getVersionPatch();
     }
+
+    Smpclass_API long long LidarLineDetector_GetAllocationCount()
+    {
+        return LidarLineDetector::allocationCount();
+    }
 }
\ No newline at end of file
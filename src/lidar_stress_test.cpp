@@ -0,0 +1,294 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <opencv2/opencv.hpp>
+#include "lidar_line_detection.h"
+#include "spdlog/spdlog.h"
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// 多实例并发压力测试：N 个检测实例（各自的相机ID与合成图像）先逐个单独运行得到基准结果与单实例吞吐，
+// 再在 N 个线程上同时运行。并发结果必须与单独运行逐位一致，每个相机的日志只写入自己的文件；
+// 输出并发总吞吐相对单实例的加速比与并行效率。
+// 以 LIDAR_COUNT_ALLOCATIONS 编译时同时检查零分配：预热后单独运行阶段的每帧检测不得申请堆内存。
+// 单独运行阶段另对合成标靶图像逐帧做相机自检（窗口搜索、连通域引擎），结果须与预热后的基准一致，
+// 其堆分配次数单独报告（OpenCV 连通域标记等函数内部的临时缓冲经 operator new 申请，不作零分配要求）。
+// 另对提取方式（阈值/列重心/列峰值）、阈值方式（固定/百分位/Otsu）与拟合方式的每种组合，
+// 检查行带并行在线程数 0/1/2/硬件线程数 下的结果与单线程逐位一致
+// 用法: LidarStressTest [实例数=4] [每实例帧数=500] [宽=1280] [高=720] [最低并行效率=0，0不检查]
+namespace {
+
+    struct Camera {
+        std::string id;
+        cv::Mat image;
+        CLidarLineDetector detector;
+        TLidarLineResult_C reference;
+        bool mismatch = false;
+        long long allocations = 0; // 预热后单独运行阶段的堆分配次数（未启用计数时为0）
+        cv::Mat target;            // 相机自检的合成标靶图像，图像过小时为空
+        TTargetConfig_C targetConfig = {};
+        TargetMovementResult_C stabilityReference = {};
+        bool stabilityMismatch = false;
+        long long stabilityAllocations = 0;
+    };
+
+    // 每个相机一条不同倾角的激光线，叠加固定种子的噪声
+    cv::Mat makeImage(int index, int width, int height)
+    {
+        cv::Mat image(height, width, CV_8UC3);
+        uint32_t seed = 12345u + static_cast<uint32_t>(index);
+        for (int y = 0; y < height; ++y) {
+            uchar* row = image.ptr<uchar>(y);
+            for (int x = 0; x < width * 3; ++x) {
+                seed = seed * 1664525u + 1013904223u;
+                row[x] = static_cast<uchar>(30 + (seed >> 24) % 40);
+            }
+        }
+        const int dy = (index % 7 - 3) * height / 40;
+        cv::line(image, cv::Point(width / 10, height / 2 - dy), cv::Point(width * 9 / 10, height / 2 + dy), cv::Scalar(255, 255, 255), 3);
+        return image;
+    }
+
+    // 相机自检标靶：浅色背景上四个黑色方块，以图像中心对称分布；方块放不下时返回空图像
+    cv::Mat makeTargetImage(int width, int height)
+    {
+        const int side = std::min(std::max(std::min(width, height) / 8, 48), 200);
+        if (width / 4 < side || height / 4 < side)
+            return cv::Mat();
+        cv::Mat image(height, width, CV_8UC3, cv::Scalar(200, 200, 200));
+        for (int i = 0; i < 4; ++i) {
+            const int cx = width / 2 + (i % 2 ? width / 4 : -width / 4);
+            const int cy = height / 2 + (i / 2 ? height / 4 : -height / 4);
+            cv::rectangle(image, cv::Rect(cx - side / 2, cy - side / 2, side, side), cv::Scalar(20, 20, 20), cv::FILLED);
+        }
+        return image;
+    }
+
+    TCMat_C toCMat(const cv::Mat& image)
+    {
+        TCMat_C c;
+        c.rows = image.rows;
+        c.cols = image.cols;
+        c.type = image.type();
+        c.data = image.data;
+        return c;
+    }
+
+    bool sameResult(const TLidarLineResult_C& a, const TLidarLineResult_C& b)
+    {
+        return a.line_detected == b.line_detected && a.line_angle == b.line_angle && a.error_code == b.error_code &&
+               a.inlier_count == b.inlier_count && a.threshold == b.threshold;
+    }
+
+    bool sameStability(const TargetMovementResult_C& a, const TargetMovementResult_C& b)
+    {
+        return a.is_stable == b.is_stable && a.dx == b.dx && a.dy == b.dy && a.error_code == b.error_code;
+    }
+
+    // 运行 frames 帧，与基准结果比较，返回耗时（秒）
+    double runFrames(Camera& camera, int frames)
+    {
+        const TCMat_C image = toCMat(camera.image);
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < frames; ++i) {
+            TLidarLineResult_C result = camera.detector.detect(image);
+            if (!sameResult(result, camera.reference))
+                camera.mismatch = true;
+        }
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // 行带并行确定性：同一图像在各线程数下的结果（含角度、内点数、迭代次数、实际阈值）必须逐位一致
+    bool checkThreadSweep(const cv::Mat& image, int width, int height)
+    {
+        const int hardware = static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u));
+        const int threadCounts[] = {0, 1, 2, hardware};
+        const char* extractionNames[] = {"阈值", "列重心", "列峰值"};
+        const char* thresholdNames[] = {"固定", "百分位", "Otsu"};
+        const char* fitNames[] = {"最小二乘", "RANSAC"};
+        const TCMat_C cimage = toCMat(image);
+        bool ok = true;
+        for (int extraction = 0; extraction < 3; ++extraction) {
+            for (int thresholdMode = 0; thresholdMode < 3; ++thresholdMode) {
+                for (int fit = 0; fit < 2; ++fit) {
+                    TLidarLineResult_C reference = {};
+                    for (int threads : threadCounts) {
+                        CLidarLineDetector detector;
+                        detector.setCameraId("sweep");
+                        detector.setOutputDir("");
+                        detector.setROI(width / 20, height / 10, width * 9 / 10, height * 8 / 10);
+                        detector.setExtractionMode(extraction);
+                        detector.setAdaptiveThreshold(thresholdMode, 0, -1);
+                        // 时间预算放宽到不会触发，迭代次数只由数据决定
+                        detector.setRobustFit(fit, 0, 100000000, 0, 0);
+                        detector.setThreadCount(threads);
+                        TLidarLineResult_C result = detector.detect(cimage);
+                        if (threads == 0) {
+                            reference = result;
+                            continue;
+                        }
+                        if (!sameResult(result, reference) || result.fit_iterations != reference.fit_iterations) {
+                            std::cout << "[错误] " << extractionNames[extraction] << "/" << thresholdNames[thresholdMode] << "/" << fitNames[fit]
+                                      << " 在 " << threads << " 线程下的结果与单线程不一致" << std::endl;
+                            ok = false;
+                        }
+                    }
+                }
+            }
+        }
+        return ok;
+    }
+
+    // 单独运行时统计堆分配：计数是进程级的，只有本线程与检测使用的工作线程在运行，增量即检测本身的分配
+    double runFramesCounted(Camera& camera, int frames)
+    {
+        const long long before = LidarLineDetector::allocationCount();
+        double seconds = runFrames(camera, frames);
+        if (before >= 0)
+            camera.allocations = LidarLineDetector::allocationCount() - before;
+        return seconds;
+    }
+
+    // 单独运行阶段的相机自检：每帧与基准比较，分配次数与检测分开统计
+    void runStabilityCounted(Camera& camera, int frames)
+    {
+        if (camera.target.empty())
+            return;
+        const TCMat_C target = toCMat(camera.target);
+        const long long before = LidarLineDetector::allocationCount();
+        for (int i = 0; i < frames; ++i) {
+            TargetMovementResult_C result = camera.detector.checkCameraStability(target, camera.targetConfig);
+            if (!sameStability(result, camera.stabilityReference))
+                camera.stabilityMismatch = true;
+        }
+        if (before >= 0)
+            camera.stabilityAllocations = LidarLineDetector::allocationCount() - before;
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+#ifdef _WIN32
+    SetConsoleOutputCP(CP_UTF8);
+#endif
+    const int instances = argc > 1 ? std::max(std::atoi(argv[1]), 1) : 4;
+    const int frames = argc > 2 ? std::max(std::atoi(argv[2]), 1) : 500;
+    const int width = argc > 3 ? std::max(std::atoi(argv[3]), 64) : 1280;
+    const int height = argc > 4 ? std::max(std::atoi(argv[4]), 64) : 720;
+    const double minEfficiency = argc > 5 ? std::atof(argv[5]) : 0.0;
+
+    std::vector<std::unique_ptr<Camera>> cameras;
+    for (int i = 0; i < instances; ++i) {
+        std::unique_ptr<Camera> camera(new Camera);
+        camera->id = "stress" + std::to_string(i);
+        camera->image = makeImage(i, width, height);
+        camera->detector.setCameraId(camera->id.c_str());
+        camera->detector.setSn(("SN" + std::to_string(i)).c_str());
+        camera->detector.setOutputDir(""); // 不输出结果图，只测检测本身
+        camera->detector.setROI(width / 20, height / 10, width * 9 / 10, height * 8 / 10);
+        camera->reference = camera->detector.detect(toCMat(camera->image));
+        if (!camera->reference.line_detected) {
+            std::cout << "[错误] 相机 " << camera->id << " 的合成图像未检测到激光线，错误码: " << camera->reference.error_code << std::endl;
+            return 1;
+        }
+        runFrames(*camera, 3); // 预热：跟踪状态建立、缓冲与日志对象就绪
+        camera->target = makeTargetImage(width, height);
+        if (!camera->target.empty()) {
+            camera->targetConfig = {width / 2.0f, height / 2.0f, 5.0f};
+            camera->detector.setTargetSearch(true, 0);
+            camera->detector.setTargetFinder(1, 0);
+            // 首帧整图搜索学到几何，之后窗口搜索；预热后的结果作为基准
+            for (int i = 0; i < 4; ++i)
+                camera->stabilityReference = camera->detector.checkCameraStability(toCMat(camera->target), camera->targetConfig);
+            if (camera->stabilityReference.error_code != 0 || !camera->stabilityReference.is_stable) {
+                std::cout << "[错误] 相机 " << camera->id << " 的合成标靶自检失败，错误码: " << camera->stabilityReference.error_code << std::endl;
+                return 1;
+            }
+        }
+        cameras.push_back(std::move(camera));
+    }
+
+    // 单实例基准：逐个单独运行
+    double serialSeconds = 0;
+    for (auto& camera : cameras) {
+        serialSeconds += runFramesCounted(*camera, frames);
+        runStabilityCounted(*camera, frames);
+    }
+    const double singleFps = static_cast<double>(frames) * instances / serialSeconds;
+
+    // 全部实例同时运行，等所有线程就绪后同时开始
+    std::atomic<int> ready{0};
+    std::atomic<bool> go{false};
+    std::vector<std::thread> threads;
+    for (auto& camera : cameras) {
+        Camera* c = camera.get();
+        threads.emplace_back([&, c] {
+            ++ready;
+            while (!go.load())
+                std::this_thread::yield();
+            runFrames(*c, frames);
+        });
+    }
+    while (ready.load() < instances)
+        std::this_thread::yield();
+    auto start = std::chrono::steady_clock::now();
+    go = true;
+    for (std::thread& t : threads)
+        t.join();
+    const double parallelSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const double parallelFps = static_cast<double>(frames) * instances / parallelSeconds;
+    const double speedup = parallelFps / singleFps;
+    const double efficiency = speedup / instances;
+
+    bool ok = checkThreadSweep(cameras.front()->image, width, height);
+    for (auto& camera : cameras) {
+        if (camera->mismatch) {
+            std::cout << "[错误] 相机 " << camera->id << " 的结果与单独运行不一致" << std::endl;
+            ok = false;
+        }
+        if (camera->allocations != 0) {
+            std::cout << "[错误] 相机 " << camera->id << " 预热后 " << frames << " 帧检测共申请堆内存 " << camera->allocations << " 次" << std::endl;
+            ok = false;
+        }
+        if (camera->stabilityMismatch) {
+            std::cout << "[错误] 相机 " << camera->id << " 的自检结果与预热后的基准不一致" << std::endl;
+            ok = false;
+        }
+        if (!camera->target.empty() && LidarLineDetector::allocationCount() >= 0)
+            std::cout << "相机 " << camera->id << " 预热后 " << frames << " 帧自检共申请堆内存 " << camera->stabilityAllocations << " 次" << std::endl;
+        // 每个实例的日志只写入自己的文件
+        std::shared_ptr<spdlog::logger> log = LidarLineDetector::cameraLogger(camera->id);
+        log->flush();
+        std::ifstream file("log/lidar_" + camera->id + ".log");
+        std::string line;
+        int lines = 0, foreign = 0;
+        while (std::getline(file, line)) {
+            ++lines;
+            foreign += line.find("[lidar_" + camera->id + "]") == std::string::npos;
+        }
+        if (lines == 0 || foreign > 0) {
+            std::cout << "[错误] 相机 " << camera->id << " 的日志异常: " << lines << " 行，其中 " << foreign << " 行不属于该相机" << std::endl;
+            ok = false;
+        }
+    }
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "实例数: " << instances << "，每实例帧数: " << frames << "，图像: " << width << "x" << height
+              << "，硬件线程: " << std::thread::hardware_concurrency() << "\n"
+              << "单实例吞吐: " << singleFps << " 帧/秒\n"
+              << "并发总吞吐: " << parallelFps << " 帧/秒\n"
+              << std::setprecision(2) << "加速比: " << speedup << "，并行效率: " << efficiency * 100 << "%" << std::endl;
+    if (LidarLineDetector::allocationCount() < 0)
+        std::cout << "未启用堆分配计数（LIDAR_COUNT_ALLOCATIONS），跳过零分配检查" << std::endl;
+    if (minEfficiency > 0 && efficiency < minEfficiency) {
+        std::cout << "[错误] 并行效率低于要求: " << minEfficiency * 100 << "%" << std::endl;
+        ok = false;
+    }
+    std::cout << (ok ? "通过" : "失败") << std::endl;
+    return ok ? 0 : 1;
+}
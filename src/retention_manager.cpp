@@ -0,0 +1,342 @@
+#include "lidar_line_detection.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <chrono>
+#include <filesystem>
+#include <algorithm>
+#include <set>
+#include <map>
+#include "spdlog/spdlog.h"
+#include "spdlog/sinks/basic_file_sink.h"
+
+// 输出目录保留策略：后台按配额与保留时间回收磁盘
+namespace LidarLineDetector {
+
+    namespace fs = std::filesystem;
+    using Clock = std::chrono::system_clock;
+
+    static std::shared_ptr<spdlog::logger> logger = spdlog::basic_logger_mt("retention_logger", "log/retention.log");
+
+    // 路径比较统一用绝对、规范化且去掉末尾分隔符的形式（"out/" 与 "out" 相同）
+    static fs::path normalized(const fs::path& path)
+    {
+        std::error_code ec;
+        fs::path p = fs::absolute(path, ec);
+        p = (ec ? path : p).lexically_normal();
+        if (!p.has_filename() && p != p.root_path())
+            p = p.parent_path();
+        return p;
+    }
+
+    // 失败图像：飞行记录转存（.llfr）或以 result_fail_ 为前缀的结果图，重启后按文件名恢复失败标记
+    static bool isFailureFile(const fs::path& path)
+    {
+        return path.extension() == ".llfr" || path.filename().string().rfind("result_fail_", 0) == 0;
+    }
+
+    struct RetentionManager::Impl {
+        // 台账按文件时间升序排列：启动扫描时排序一次，之后登记的新文件总是追加在末尾
+        struct Entry {
+            std::string path;
+            uint64_t bytes;
+            Clock::time_point time;
+        };
+        struct Pending {
+            std::string path;
+            bool failure;
+        };
+
+        fs::path root;   // 已规范化
+        Policy policy;   // 后台线程使用的策略，每个周期开始时从 requested 复制
+        std::deque<Entry> normal;
+        std::deque<Entry> failures;
+        std::deque<Entry> logs; // 日志文件可能仍在写入：只按保留时间删除（删除前重新确认修改时间），不计入配额
+        uint64_t bytes = 0;     // 配额统计：普通文件与失败图像
+        std::set<std::string> guarded;  // 本周期开始时的受保护文件副本（仅后台线程使用）
+        std::set<std::string> liveLogs; // 本周期开始时本进程日志仍打开着的文件（仅后台线程使用）
+
+        mutable std::mutex mutex; // 保护 requested、pending、protectedPaths、stats、stop
+        std::condition_variable wake;
+        Policy requested;
+        std::vector<Pending> pending;
+        std::set<std::string> protectedPaths; // 正在写入的文件（规范化路径）
+        Stats stats;
+        bool stop = false;
+        std::thread worker;
+
+        bool isGuarded(const std::string& path) const
+        {
+            return !guarded.empty() && guarded.count(normalized(path).string()) > 0;
+        }
+
+        // 日志写端在进程存续期间一直打开文件：删除后 Linux 上之后的日志写入已删除的 inode，Windows 上删除总是失败。
+        // 各模块与相机日志都是 spdlog 的 basic_file_sink，从日志注册表取出仍在使用的文件，不回收
+        void refreshLiveLogs()
+        {
+            liveLogs.clear();
+            spdlog::apply_all([this](std::shared_ptr<spdlog::logger> l) {
+                for (const spdlog::sink_ptr& sink : l->sinks()) {
+                    if (auto file = std::dynamic_pointer_cast<spdlog::sinks::basic_file_sink_mt>(sink))
+                        liveLogs.insert(normalized(file->filename()).string());
+                }
+            });
+        }
+
+        bool isLiveLog(const std::string& path) const
+        {
+            return !liveLogs.empty() && liveLogs.count(normalized(path).string()) > 0;
+        }
+
+        // 每个周期开始时（持有 mutex）取得最新的策略与受保护文件
+        void beginCycle()
+        {
+            policy = requested;
+            guarded = protectedPaths;
+        }
+
+        static Clock::time_point toSystemTime(fs::file_time_type written)
+        {
+            return Clock::now() - std::chrono::duration_cast<Clock::duration>(fs::file_time_type::clock::now() - written);
+        }
+
+        void scanRoots()
+        {
+            std::vector<std::pair<Entry, int>> found; // 0:普通 1:失败 2:日志
+            std::error_code ec;
+            const bool logRoot = root.filename() == "log";
+            for (fs::recursive_directory_iterator it(root, ec), end; !ec && it != end; it.increment(ec)) {
+                std::error_code fe;
+                if (!it->is_regular_file(fe) || fe)
+                    continue;
+                uint64_t size = it->file_size(fe);
+                auto written = it->last_write_time(fe);
+                if (fe || isGuarded(it->path().string()))
+                    continue;
+                Entry e{it->path().string(), size, toSystemTime(written)};
+                int kind = logRoot || it->path().extension() == ".log" ? 2 : (isFailureFile(it->path()) ? 1 : 0);
+                found.emplace_back(e, kind);
+            }
+            std::sort(found.begin(), found.end(), [](const std::pair<Entry, int>& a, const std::pair<Entry, int>& b) { return a.first.time < b.first.time; });
+            for (auto& f : found) {
+                if (f.second != 2)
+                    bytes += f.first.bytes;
+                (f.second == 0 ? normal : f.second == 1 ? failures : logs).push_back(f.first);
+            }
+            logger->info("保留策略启动扫描完成: {}，{} 个文件，配额内 {} 字节", root.string(), found.size(), bytes);
+        }
+
+        // 登记的文件都已写完（同步写盘、异步写盘器写完、分段定稿或转存之后才登记），取大小后入账
+        void admit(const std::vector<Pending>& batch)
+        {
+            const auto now = Clock::now();
+            for (const Pending& p : batch) {
+                std::error_code ec;
+                uint64_t size = fs::file_size(p.path, ec);
+                if (ec || isGuarded(p.path)) {
+                    logger->debug("登记的文件不存在或受保护，不入账: {}", p.path);
+                    continue;
+                }
+                bytes += size;
+                (p.failure ? failures : normal).push_back(Entry{p.path, size, now});
+            }
+        }
+
+        // dir 是否严格位于根目录之内（不含根目录本身）
+        bool insideRoot(const fs::path& dir) const
+        {
+            auto r = root.begin();
+            auto d = dir.begin();
+            for (; r != root.end() && d != dir.end() && *r == *d; ++r, ++d) {}
+            return r == root.end() && d != dir.end();
+        }
+
+        // 删除台账最前面的文件，并清理因此变空的分片目录（不越过根目录）；返回是否真正回收了空间
+        bool evictFront(std::deque<Entry>& ledger, bool counted, Stats& delta)
+        {
+            Entry e = ledger.front();
+            ledger.pop_front();
+            if (counted)
+                bytes -= std::min(bytes, e.bytes);
+            if (isGuarded(e.path))
+                return false; // 正在写入：移出台账不删除，关闭后重新登记或下次启动扫描时统计
+            std::error_code ec;
+            if (!fs::remove(e.path, ec)) {
+                if (ec) {
+                    ++delta.deleteFailures;
+                    logger->warn("删除文件失败: {} ({})", e.path, ec.message());
+                }
+                return false; // 已被外部删除或删除失败：移出台账，下次启动扫描时重新统计
+            }
+            ++delta.reclaimedFiles;
+            delta.reclaimedBytes += e.bytes;
+            bool removedDirectory = false;
+            for (fs::path dir = normalized(fs::path(e.path).parent_path()); insideRoot(dir); dir = dir.parent_path()) {
+                if (!fs::is_empty(dir, ec) || ec || !fs::remove(dir, ec))
+                    break;
+                removedDirectory = true;
+            }
+            if (removedDirectory)
+                forgetArtifactShards();
+            return true;
+        }
+
+        static void requeue(std::deque<Entry>& ledger, Entry e, Clock::time_point time)
+        {
+            e.time = time;
+            auto pos = std::upper_bound(ledger.begin(), ledger.end(), e, [](const Entry& a, const Entry& b) { return a.time < b.time; });
+            ledger.insert(pos, e);
+        }
+
+        // 删除超龄文件。删除前重新读取修改时间：入账后又被写过的文件按新时间重新排队；
+        // 本进程日志仍打开着的文件不删除，推迟一个保留周期后再检查
+        void expire(std::deque<Entry>& ledger, bool counted, int maxAgeSeconds, Clock::time_point now, Stats& delta)
+        {
+            if (maxAgeSeconds <= 0)
+                return;
+            const auto cutoff = now - std::chrono::seconds(maxAgeSeconds);
+            while (!ledger.empty() && ledger.front().time < cutoff) {
+                Entry e = ledger.front();
+                if (isLiveLog(e.path)) {
+                    ledger.pop_front();
+                    requeue(ledger, e, now);
+                    continue;
+                }
+                std::error_code ec;
+                auto written = fs::last_write_time(e.path, ec);
+                if (!ec && toSystemTime(written) >= cutoff) {
+                    ledger.pop_front();
+                    requeue(ledger, e, toSystemTime(written));
+                    continue;
+                }
+                if (evictFront(ledger, counted, delta))
+                    ++delta.expiredFiles;
+            }
+        }
+
+        void enforce()
+        {
+            Stats delta;
+            const auto now = Clock::now();
+            expire(normal, true, policy.maxAgeSeconds, now, delta);
+            expire(failures, true, policy.failureMaxAgeSeconds, now, delta);
+            if (!logs.empty())
+                refreshLiveLogs();
+            expire(logs, false, std::max(policy.maxAgeSeconds, policy.failureMaxAgeSeconds), now, delta);
+            // 超出配额：先删最旧的普通文件，普通文件删完才动失败图像；日志不计入配额，也不因配额删除
+            while (policy.quotaBytes > 0 && bytes > policy.quotaBytes && !(normal.empty() && failures.empty())) {
+                if (evictFront(normal.empty() ? failures : normal, true, delta))
+                    ++delta.quotaEvictions;
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            stats.trackedBytes = bytes;
+            stats.trackedFiles = normal.size() + failures.size() + logs.size();
+            stats.reclaimedBytes += delta.reclaimedBytes;
+            stats.reclaimedFiles += delta.reclaimedFiles;
+            stats.expiredFiles += delta.expiredFiles;
+            stats.quotaEvictions += delta.quotaEvictions;
+            stats.deleteFailures += delta.deleteFailures;
+            if (delta.reclaimedFiles > 0)
+                logger->info("回收 {} 个文件，{} 字节；当前配额内占用 {} 字节", delta.reclaimedFiles, delta.reclaimedBytes, bytes);
+        }
+
+        void run()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                beginCycle();
+            }
+            scanRoots();
+            enforce();
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!stop) {
+                wake.wait_for(lock, std::chrono::milliseconds(std::max(requested.intervalMs, 100)), [&] { return stop; });
+                if (stop)
+                    break;
+                std::vector<Pending> batch;
+                batch.swap(pending);
+                beginCycle();
+                lock.unlock();
+                admit(batch);
+                enforce();
+                lock.lock();
+            }
+        }
+    };
+
+    RetentionManager::RetentionManager(const std::string& root, const Policy& policy) : m_impl(new Impl)
+    {
+        m_impl->root = normalized(root);
+        m_impl->requested = policy;
+        m_impl->worker = std::thread([this] { m_impl->run(); });
+    }
+
+    // 进程级注册表：同一根目录只有一个实例，最后一个持有者释放后停止后台线程
+    std::shared_ptr<RetentionManager> RetentionManager::forRoot(const std::string& root, const Policy& policy)
+    {
+        static std::mutex registryMutex;
+        static std::map<std::string, std::weak_ptr<RetentionManager>> registry;
+        if (root.empty())
+            return nullptr;
+        const std::string key = normalized(root).string();
+        std::lock_guard<std::mutex> lock(registryMutex);
+        std::shared_ptr<RetentionManager> manager = registry[key].lock();
+        if (manager) {
+            manager->setPolicy(policy);
+            return manager;
+        }
+        manager.reset(new RetentionManager(root, policy));
+        registry[key] = manager;
+        return manager;
+    }
+
+    void RetentionManager::setPolicy(const Policy& policy)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_impl->mutex);
+            m_impl->requested = policy;
+        }
+        logger->info("保留策略更新: {}，配额 {} 字节，保留 {} 秒，失败图像保留 {} 秒", m_impl->root.string(), policy.quotaBytes,
+                     policy.maxAgeSeconds, policy.failureMaxAgeSeconds);
+    }
+
+    RetentionManager::~RetentionManager()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_impl->mutex);
+            m_impl->stop = true;
+        }
+        m_impl->wake.notify_all();
+        m_impl->worker.join();
+    }
+
+    void RetentionManager::track(const std::string& path, bool failure)
+    {
+        if (path.empty())
+            return;
+        std::lock_guard<std::mutex> lock(m_impl->mutex);
+        m_impl->pending.push_back(Impl::Pending{path, failure});
+    }
+
+    void RetentionManager::protect(const std::string& path)
+    {
+        if (path.empty())
+            return;
+        std::lock_guard<std::mutex> lock(m_impl->mutex);
+        m_impl->protectedPaths.insert(normalized(path).string());
+    }
+
+    void RetentionManager::release(const std::string& path)
+    {
+        std::lock_guard<std::mutex> lock(m_impl->mutex);
+        m_impl->protectedPaths.erase(normalized(path).string());
+    }
+
+    RetentionManager::Stats RetentionManager::stats() const
+    {
+        std::lock_guard<std::mutex> lock(m_impl->mutex);
+        return m_impl->stats;
+    }
+
+} // namespace LidarLineDetector
@@ -0,0 +1,186 @@
+#include "lidar_line_detection.h"
+#include <mutex>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include "spdlog/spdlog.h"
+#include "spdlog/sinks/basic_file_sink.h"
+
+// 会话视频输出：分段MJPEG/AVI与旁路索引
+namespace LidarLineDetector {
+
+    static std::shared_ptr<spdlog::logger> logger = spdlog::basic_logger_mt("video_logger", "log/session_video.log");
+
+    // 取路径中的文件名部分（索引中只记录分段文件名，会话目录整体搬移后仍可读取）
+    static std::string fileNameOf(const std::string& path)
+    {
+        size_t pos = path.find_last_of("/\\");
+        return pos == std::string::npos ? path : path.substr(pos + 1);
+    }
+
+    static std::string directoryOf(const std::string& path)
+    {
+        size_t pos = path.find_last_of("/\\");
+        return pos == std::string::npos ? std::string() : path.substr(0, pos + 1);
+    }
+
+    struct SessionVideoSink::Impl {
+        std::string basePath;
+        int framesPerSegment = 0;
+        double fps = 0;
+        int quality = 0;
+        std::mutex mutex;
+        cv::VideoWriter writer;
+        std::string segmentPath;
+        cv::Size frameSize;
+        int segment = 0;       // 当前分段编号（从1开始）
+        int segmentFrames = 0; // 当前分段已写帧数
+        std::ofstream index;
+        RetentionManager* retention = nullptr;
+
+        // 关闭当前分段，分段定稿后才登记到保留策略台账
+        void closeSegment()
+        {
+            if (!writer.isOpened())
+                return;
+            writer.release();
+            if (retention != nullptr) {
+                retention->release(segmentPath);
+                retention->track(segmentPath, false);
+            }
+        }
+
+        bool openSegment(const cv::Size& size)
+        {
+            closeSegment();
+            std::ostringstream name;
+            name << basePath << "_" << std::setw(4) << std::setfill('0') << ++segment << ".avi";
+            segmentPath = name.str();
+            if (!writer.open(segmentPath, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'), fps, size, true)) {
+                logger->error("无法创建会话视频分段: {}", segmentPath);
+                return false;
+            }
+            writer.set(cv::VIDEOWRITER_PROP_QUALITY, quality);
+            if (retention != nullptr)
+                retention->protect(segmentPath); // 写入中的分段不参与回收
+            frameSize = size;
+            segmentFrames = 0;
+            logger->info("开始会话视频分段: {} ({}x{})", segmentPath, size.width, size.height);
+            return true;
+        }
+    };
+
+    SessionVideoSink::SessionVideoSink(const std::string& basePath, int framesPerSegment, double fps, int quality, RetentionManager* retention)
+        : m_impl(new Impl)
+    {
+        m_impl->basePath = basePath;
+        m_impl->retention = retention;
+        m_impl->framesPerSegment = std::max(framesPerSegment, 1);
+        m_impl->fps = fps > 0 ? fps : 10.0;
+        m_impl->quality = std::min(std::max(quality, 0), 100);
+        m_impl->index.open(basePath + ".idx", std::ios::app);
+        if (!m_impl->index)
+            logger->error("无法创建会话视频索引: {}.idx", basePath);
+        if (retention != nullptr)
+            retention->protect(basePath + ".idx");
+    }
+
+    // 索引与最后一个分段在会话结束时定稿登记；保留策略先于会话析构
+    SessionVideoSink::~SessionVideoSink()
+    {
+        m_impl->closeSegment();
+        m_impl->index.close();
+        if (m_impl->retention != nullptr) {
+            m_impl->retention->release(indexPath());
+            m_impl->retention->track(indexPath(), false);
+        }
+    }
+
+    bool SessionVideoSink::append(const cv::Mat& bgr, const std::string& sn, std::string& location)
+    {
+        Impl& impl = *m_impl;
+        if (bgr.empty() || bgr.type() != CV_8UC3)
+            return false;
+        std::lock_guard<std::mutex> lock(impl.mutex);
+        if (!impl.writer.isOpened() || impl.segmentFrames >= impl.framesPerSegment || bgr.size() != impl.frameSize) {
+            if (!impl.openSegment(bgr.size()))
+                return false;
+        }
+        impl.writer.write(bgr);
+        const int frame = impl.segmentFrames++;
+        const auto timestampUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        // 逐行刷新：进程异常退出时索引与已写入的帧保持一致
+        impl.index << fileNameOf(impl.segmentPath) << ',' << frame << ',' << timestampUs << ','
+                   << bgr.cols << ',' << bgr.rows << ',' << sn << std::endl;
+        location = impl.segmentPath + "#" + std::to_string(frame);
+        return true;
+    }
+
+    void SessionVideoSink::setRetention(RetentionManager* retention)
+    {
+        std::lock_guard<std::mutex> lock(m_impl->mutex);
+        // 保留策略实例按根目录在进程内共享，换下的实例可能仍在运行：先解除旧实例上的保护
+        if (m_impl->retention != nullptr) {
+            m_impl->retention->release(indexPath());
+            if (m_impl->writer.isOpened())
+                m_impl->retention->release(m_impl->segmentPath);
+        }
+        m_impl->retention = retention;
+        if (retention == nullptr)
+            return;
+        retention->protect(indexPath());
+        if (m_impl->writer.isOpened())
+            retention->protect(m_impl->segmentPath);
+    }
+
+    std::string SessionVideoSink::indexPath() const
+    {
+        return m_impl->basePath + ".idx";
+    }
+
+    bool readSessionFrame(const std::string& indexPath, const std::string& sn, cv::Mat& frame, int occurrence)
+    {
+        std::ifstream index(indexPath);
+        if (!index) {
+            logger->error("无法打开会话视频索引: {}", indexPath);
+            return false;
+        }
+        std::string line, segment;
+        int frameIndex = -1;
+        int seen = 0;
+        while (std::getline(index, line)) {
+            // 分段文件名,帧序号,时间戳,宽,高,SN（SN在最后，可包含逗号）
+            std::istringstream fields(line);
+            std::string file, frameText, skip;
+            if (!std::getline(fields, file, ',') || !std::getline(fields, frameText, ',') ||
+                !std::getline(fields, skip, ',') || !std::getline(fields, skip, ',') || !std::getline(fields, skip, ','))
+                continue;
+            std::string entrySn;
+            std::getline(fields, entrySn);
+            if (entrySn != sn)
+                continue;
+            if (occurrence < 0 || seen == occurrence) {
+                segment = file;
+                frameIndex = std::atoi(frameText.c_str());
+            }
+            if (seen++ == occurrence)
+                break;
+        }
+        if (frameIndex < 0) {
+            logger->warn("会话视频索引中没有SN: {}", sn);
+            return false;
+        }
+
+        const std::string segmentPath = directoryOf(indexPath) + segment;
+        cv::VideoCapture capture(segmentPath);
+        if (capture.isOpened())
+            capture.set(cv::CAP_PROP_POS_FRAMES, frameIndex);
+        if (!capture.isOpened() || !capture.read(frame) || frame.empty()) {
+            logger->error("读取会话视频帧失败: {}#{}", segmentPath, frameIndex);
+            return false;
+        }
+        return true;
+    }
+
+} // namespace LidarLineDetector
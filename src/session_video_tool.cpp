@@ -0,0 +1,31 @@
+#include <iostream>
+#include <cstdlib>
+#include <opencv2/opencv.hpp>
+#include "lidar_line_detection.h"
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// 会话视频取帧工具：按SN从会话索引中取回一帧并保存为图像
+// 用法: SessionVideoTool <会话索引.idx> <SN> <输出图像> [序号，默认取最后一帧]
+int main(int argc, char** argv) {
+#ifdef _WIN32
+    SetConsoleOutputCP(CP_UTF8);
+#endif
+    if (argc < 4) {
+        std::cout << "用法: " << argv[0] << " <会话索引.idx> <SN> <输出图像> [序号]" << std::endl;
+        return 1;
+    }
+    const int occurrence = argc > 4 ? std::atoi(argv[4]) : -1;
+    cv::Mat frame;
+    if (!LidarLineDetector::readSessionFrame(argv[1], argv[2], frame, occurrence)) {
+        std::cout << "[错误] 会话视频中找不到SN: " << argv[2] << std::endl;
+        return 1;
+    }
+    if (!cv::imwrite(argv[3], frame)) {
+        std::cout << "[错误] 保存图像失败: " << argv[3] << std::endl;
+        return 1;
+    }
+    std::cout << "已保存: " << argv[3] << " (" << frame.cols << "x" << frame.rows << ")" << std::endl;
+    return 0;
+}